@@ -0,0 +1,143 @@
+#include "plumed/core/Value.h"
+#include "plumed/tools/Grid.h"
+#include "plumed/tools/Tools.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+using namespace PLMD;
+
+// Tests spline interpolation on grids with up to five dimensions.
+// Grids with one to four dimensions use the specialized code,
+// whereas grids with five dimensions use the generic one.
+// The specialized code is also compared with the generic one using
+// five-dimensional grids where the function depends only on the first dimensions.
+
+// the function stored on the grid, depending only on the first nactive variables
+double function(const std::vector<double> &x, std::vector<double> &der, unsigned nactive) {
+  double f = 1.0;
+  for (unsigned i = 0; i < nactive; ++i) f *= 1.5 + std::cos(x[i] * (i + 1));
+  for (unsigned i = 0; i < x.size(); ++i) {
+    if (i < nactive) der[i] = -f / (1.5 + std::cos(x[i] * (i + 1))) * (i + 1) * std::sin(x[i] * (i + 1));
+    else der[i] = 0.0;
+  }
+  return f;
+}
+
+template <class T>
+std::unique_ptr<GridBase> createGrid(unsigned dim, unsigned nactive) {
+  std::vector<std::unique_ptr<Value>> values;
+  std::vector<Value *> args;
+  std::vector<std::string> gmin, gmax;
+  std::vector<unsigned> nbin;
+  for (unsigned i = 0; i < dim; ++i) {
+    values.emplace_back(new Value("x" + std::to_string(i)));
+// odd dimensions are periodic
+    if (i % 2) {
+      values.back()->setDomain("-pi", "pi");
+      gmin.push_back("-pi");
+      gmax.push_back("pi");
+    } else {
+      values.back()->setNotPeriodic();
+      gmin.push_back("-1.0");
+      gmax.push_back("2.0");
+    }
+    nbin.push_back(6 + i);
+    args.push_back(values.back().get());
+  }
+  std::unique_ptr<GridBase> grid(new T("f", args, gmin, gmax, nbin, true, true));
+  GridBase::index_t size = 1;
+  for (auto n : grid->getNbin()) size *= n;
+  std::vector<double> x(dim), der(dim);
+  for (GridBase::index_t i = 0; i < size; ++i) {
+    grid->getPoint(i, x);
+    double f = function(x, der, nactive);
+    grid->setValueAndDerivatives(i, f, der);
+  }
+  return grid;
+}
+
+// deterministic points inside the grid
+std::vector<double> getPoints(unsigned dim, unsigned npoints) {
+  std::vector<double> points(dim * npoints);
+  unsigned long seed = 12345;
+  for (auto &p : points) {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    p = double(seed) / 2147483648.0;
+  }
+  for (unsigned i = 0; i < npoints; ++i) for (unsigned j = 0; j < dim; ++j) {
+      if (j % 2) points[i * dim + j] = -pi + 2.0 * pi * points[i * dim + j];
+      else points[i * dim + j] = -1.0 + 3.0 * points[i * dim + j];
+    }
+  return points;
+}
+
+void test(std::ofstream &ofs, const std::string &name, GridBase &grid, GridBase &reference) {
+  const unsigned dim = grid.getDimension();
+  const unsigned npoints = 50;
+  std::vector<double> points = getPoints(dim, npoints);
+  unsigned nvalue = 0, nreference = 0;
+  std::vector<double> x(dim), der(dim), refder(dim);
+  for (unsigned i = 0; i < npoints; ++i) {
+    for (unsigned j = 0; j < dim; ++j) x[j] = points[i * dim + j];
+    double f = grid.getValueAndDerivatives(x, der);
+    if (f != grid.getValue(x)) nvalue++;
+    double ref = reference.getValueAndDerivatives(x, refder);
+    if (f != ref) nreference++;
+    for (unsigned j = 0; j < dim; ++j) if (der[j] != refder[j]) nreference++;
+    if (i < 3) {
+      ofs << name << " dim=" << dim << " point " << i << ":";
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), " %.6f", f);
+      ofs << buffer;
+      for (unsigned j = 0; j < dim; ++j) {
+        std::snprintf(buffer, sizeof(buffer), " %.6f", der[j]);
+        ofs << buffer;
+      }
+      ofs << std::endl;
+    }
+  }
+  ofs << name << " dim=" << dim << " mismatches: getValue " << nvalue
+      << " dense " << nreference << std::endl;
+}
+
+// compares a grid with one to four dimensions with a five-dimensional grid
+// storing the same function, which is interpolated with the generic code
+void testGeneric(std::ofstream &ofs, GridBase &grid, GridBase &generic) {
+  const unsigned dim = grid.getDimension();
+  const unsigned npoints = 50;
+  std::vector<double> points = getPoints(5, npoints);
+  unsigned nmismatch = 0;
+  std::vector<double> x(dim), der(dim), xg(5), derg(5);
+  for (unsigned i = 0; i < npoints; ++i) {
+    for (unsigned j = 0; j < 5; ++j) xg[j] = points[i * 5 + j];
+    for (unsigned j = 0; j < dim; ++j) x[j] = xg[j];
+    double f = grid.getValueAndDerivatives(x, der);
+    double fg = generic.getValueAndDerivatives(xg, derg);
+    // the five-dimensional grid sums more contributions, so results agree up to rounding
+    if (std::abs(f - fg) > 1e-10) nmismatch++;
+    for (unsigned j = 0; j < dim; ++j) if (std::abs(der[j] - derg[j]) > 1e-10) nmismatch++;
+    for (unsigned j = dim; j < 5; ++j) if (std::abs(derg[j]) > 1e-10) nmismatch++;
+  }
+  ofs << "Grid dim=" << dim << " mismatches: generic " << nmismatch << std::endl;
+}
+
+int main() {
+  std::ofstream ofs("output");
+  for (unsigned dim = 1; dim <= 5; ++dim) {
+    auto dense = createGrid<Grid>(dim, dim);
+    test(ofs, "Grid", *dense, *dense);
+    auto sparse = createGrid<SparseGrid>(dim, dim);
+    test(ofs, "SparseGrid", *sparse, *dense);
+    auto tiled = createGrid<TiledSparseGrid>(dim, dim);
+    test(ofs, "TiledSparseGrid", *tiled, *dense);
+  }
+  for (unsigned dim = 1; dim <= 4; ++dim) {
+    auto dense = createGrid<Grid>(dim, dim);
+    auto generic = createGrid<Grid>(5, dim);
+    testGeneric(ofs, *dense, *generic);
+  }
+  return 0;
+}
@@ -0,0 +1,45 @@
+#include "plumed/tools/SwitchingFunction.h"
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace PLMD;
+
+// compare the batch interface with calculateSqr() called on each element
+int testBatch(std::ofstream &ofs,const std::string & definition) {
+  ofs << definition << std::endl;
+  SwitchingFunction sf;
+  std::string errors;
+  sf.set(definition,errors);
+  if(errors.length()>0) {
+    ofs << errors << std::endl;
+    return 1;
+  }
+  const unsigned n=101;
+  std::vector<double> distance2(n),value(n),dfunc(n);
+  for(unsigned i=0; i<n; i++) distance2[i]=(0.02*i)*(0.02*i);
+  sf.calculateSqr(distance2.data(),value.data(),dfunc.data(),n);
+  unsigned ndiff=0;
+  for(unsigned i=0; i<n; i++) {
+    double df;
+    double v=sf.calculateSqr(distance2[i],df);
+    if(v!=value[i] || df!=dfunc[i]) ndiff++;
+  }
+  ofs << "differences " << ndiff << std::endl;
+  for(unsigned i=0; i<n; i+=20) ofs << std::setprecision(8) << distance2[i] << " " << value[i] << " " << dfunc[i] << std::endl;
+  return 0;
+}
+
+int main() {
+  std::ofstream ofs("output");
+  testBatch(ofs,"RATIONAL R_0=0.5");
+  testBatch(ofs,"RATIONAL R_0=0.5 NN=8 MM=16 D_MAX=1.5");
+  testBatch(ofs,"RATIONAL R_0=0.5 NN=6 MM=10");
+  testBatch(ofs,"RATIONAL R_0=0.5 D_0=0.2 NN=5 MM=9");
+  testBatch(ofs,"EXP R_0=0.4 D_0=0.3");
+  testBatch(ofs,"GAUSSIAN R_0=0.4 D_0=0.1 D_MAX=1.5");
+  testBatch(ofs,"GAUSSIAN R_0=0.4");
+  testBatch(ofs,"CUSTOM FUNC=1/(1+x2^3) R_0=0.5 D_MAX=1.8");
+  return 0;
+}
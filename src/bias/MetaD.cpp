@@ -33,6 +33,7 @@
 #include "tools/File.h"
 #include <ctime>
 #include <numeric>
+#include <algorithm>
 #if defined(__PLUMED_HAS_GETCWD)
 #include <unistd.h>
 #endif
@@ -497,6 +498,7 @@ private:
   void   readGaussians(IFile*);
   void   writeGaussian(const Gaussian&,OFile&);
   void   addGaussian(const Gaussian&);
+  void   addGaussians(const std::vector<Gaussian>&);
   double getHeight(const std::vector<double>&);
   void   temperHeight(double &height, const TemperingSpecs &t_specs, const double tempering_bias);
   double getBias(const std::vector<double>&);
@@ -506,6 +508,7 @@ private:
   double getGaussianNormalization(const Gaussian&);
   std::vector<unsigned> getGaussianSupport(const Gaussian&);
   bool   scanOneHill(IFile* ifile, std::vector<Value>& v, std::vector<double>& center, std::vector<double>& sigma, double& height, bool& multivariate);
+  void   getMultivariateSigma(const Matrix<double>& lower, std::vector<double>& sigma);
   void   computeReweightingFactor();
   double getTransitionBarrierBias();
   void   updateFrequencyAdaptiveStride();
@@ -558,6 +561,7 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","GRID_BIN","the number of bins for the grid");
   keys.add("optional","GRID_SPACING","the approximate grid spacing (to be used as an alternative or together with GRID_BIN)");
   keys.addFlag("GRID_SPARSE",false,"use a sparse grid to store hills");
+  keys.addFlag("GRID_SPARSE_TILED",false,"use a sparse grid to store hills, where blocks of neighboring bins are stored together in a hash table. This is faster than GRID_SPARSE");
   keys.addFlag("GRID_NOSPLINE",false,"don't use spline interpolation with grids");
   keys.add("optional","GRID_WSTRIDE","write the grid to a file every N steps");
   keys.add("optional","GRID_WFILE","the file on which to write the grid");
@@ -816,6 +820,9 @@ MetaD::MetaD(const ActionOptions& ao):
 
   bool sparsegrid=false;
   parseFlag("GRID_SPARSE",sparsegrid);
+  bool tiledgrid=false;
+  parseFlag("GRID_SPARSE_TILED",tiledgrid);
+  if(tiledgrid) sparsegrid=true;
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -1009,7 +1016,8 @@ MetaD::MetaD(const ActionOptions& ao):
     for(unsigned i=0; i<gbin.size(); ++i) log.printf(" %u",gbin[i]);
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
-    if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(tiledgrid) {log.printf("  Grid uses sparse grid stored in tiles\n");}
+    else if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
     if(wgridstride_>0) {log.printf("  Grid is written on file %s with stride %d\n",gridfilename_.c_str(),wgridstride_);}
   }
 
@@ -1177,7 +1185,8 @@ MetaD::MetaD(const ActionOptions& ao):
       }
       std::string funcl=getLabel() + ".bias";
       if(!sparsegrid) {BiasGrid_=Tools::make_unique<Grid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
-      else {BiasGrid_=Tools::make_unique<SparseGrid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
+      else if(!tiledgrid) {BiasGrid_=Tools::make_unique<SparseGrid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
+      else {BiasGrid_=Tools::make_unique<TiledSparseGrid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
       std::vector<std::string> actualmin=BiasGrid_->getMin();
       std::vector<std::string> actualmax=BiasGrid_->getMax();
       for(unsigned i=0; i<getNumberOfArguments(); i++) {
@@ -1208,7 +1217,7 @@ MetaD::MetaD(const ActionOptions& ao):
         error("The GRID file you want to read: " + gridreadfilename_ + ", cannot be found!");
       }
       std::string funcl=getLabel() + ".bias";
-      BiasGrid_=GridBase::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
+      BiasGrid_=GridBase::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true, tiledgrid);
       if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
       for(unsigned i=0; i<getNumberOfArguments(); ++i) {
         if( getPntrToArgument(i)->isPeriodic()!=BiasGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
@@ -1446,13 +1455,57 @@ void MetaD::readGaussians(IFile *ifile)
   std::vector<Value> tmpvalues;
   for(unsigned j=0; j<getNumberOfArguments(); ++j) tmpvalues.push_back( Value( this, getPntrToArgument(j)->getName(), false ) );
 
+  // hills are added to the bias in blocks
+  const std::size_t blocksize=4096;
+  std::vector<Gaussian> hills;
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> columns;
   while(scanOneHill(ifile,tmpvalues,center,sigma,height,multivariate))
   {
     nhills++;
     // note that for gamma=1 we store directly -F
     if(welltemp_ && biasf_>1.0) height*=(biasf_-1.0)/biasf_;
-    addGaussian(Gaussian(multivariate,height,center,sigma));
+    hills.push_back(Gaussian(multivariate,height,center,sigma));
+    if(hills.size()>=blocksize) {addGaussians(hills); hills.clear();}
+
+    // the hills that follow share the same header and are read in bulk.
+    // columns are located by name, header and constant fields are checked by scanOneHill()
+    ifile->getColumnList(names);
+    auto column=[&](const std::string & name) {
+      return std::find(names.begin(),names.end(),name)-names.begin();
+    };
+    const std::size_t iheight=column("height");
+    std::vector<std::size_t> icenter(ncv), isigma;
+    for(unsigned i=0; i<ncv; ++i) icenter[i]=column(getPntrToArgument(i)->getName());
+    if(multivariate) {
+      for(unsigned i=0; i<ncv; i++) for(unsigned j=0; j<ncv-i; j++)
+          isigma.push_back(column("sigma_"+getPntrToArgument(j+i)->getName()+"_"+getPntrToArgument(j)->getName()));
+    } else {
+      for(unsigned i=0; i<ncv; ++i) isigma.push_back(column("sigma_"+getPntrToArgument(i)->getName()));
+    }
+    Matrix<double> lower(ncv,ncv);
+    while(std::size_t nread=ifile->scanColumns(names,columns,blocksize)) {
+      for(std::size_t n=0; n<nread; n++) {
+        for(unsigned i=0; i<ncv; ++i) {
+          tmpvalues[i].set(columns[icenter[i]][n]);
+          center[i]=tmpvalues[i].get();
+        }
+        if(multivariate) {
+          unsigned k=0;
+          for(unsigned i=0; i<ncv; i++) for(unsigned j=0; j<ncv-i; j++) lower(j+i,j)=columns[isigma[k++]][n];
+          getMultivariateSigma(lower,sigma);
+        } else {
+          for(unsigned i=0; i<ncv; ++i) sigma[i]=columns[isigma[i]][n];
+        }
+        height=columns[iheight][n];
+        nhills++;
+        if(welltemp_ && biasf_>1.0) height*=(biasf_-1.0)/biasf_;
+        hills.push_back(Gaussian(multivariate,height,center,sigma));
+      }
+      if(hills.size()>=blocksize) {addGaussians(hills); hills.clear();}
+    }
   }
+  addGaussians(hills);
   log.printf("      %d Gaussians read\n",nhills);
 }
 
@@ -1508,47 +1561,86 @@ void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
 }
 
 void MetaD::addGaussian(const Gaussian& hill)
+{
+  addGaussians(std::vector<Gaussian>(1,hill));
+}
+
+void MetaD::addGaussians(const std::vector<Gaussian>& hills)
 {
   if(grid_) {
     size_t ncv=getNumberOfArguments();
-    std::vector<unsigned> nneighb=getGaussianSupport(hill);
-    std::vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(hill.center,nneighb);
     std::vector<double> der(ncv);
     std::vector<double> xx(ncv);
-    if(comm.Get_size()==1) {
-      // for performance reasons and thread safety
-      std::vector<double> dp(ncv);
-      for(size_t i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) der[j]=0.0;
-        BiasGrid_->getPoint(ineigh,xx);
-        double bias=evaluateGaussianAndDerivatives(xx,hill,der,dp);
-        BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
-      }
-    } else {
-      unsigned stride=comm.Get_size();
-      unsigned rank=comm.Get_rank();
-      std::vector<double> allder(ncv*neighbors.size(),0.0);
-      std::vector<double> n_der(ncv,0.0);
-      std::vector<double> allbias(neighbors.size(),0.0);
-      // for performance reasons and thread safety
-      std::vector<double> dp(ncv);
-      for(unsigned i=rank; i<neighbors.size(); i+=stride) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) n_der[j]=0.0;
-        BiasGrid_->getPoint(ineigh,xx);
-        allbias[i]=evaluateGaussianAndDerivatives(xx,hill,n_der,dp);
-        for(unsigned j=0; j<ncv; j++) allder[ncv*i+j]=n_der[j];
-      }
-      comm.Sum(allbias);
-      comm.Sum(allder);
-      for(unsigned i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) der[j]=allder[ncv*i+j];
-        BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+    unsigned nt=OpenMP::getNumThreads();
+    // maximum number of bins evaluated at once, to limit the memory used for buffers
+    const size_t maxbins=1048576;
+    size_t first=0;
+    while(first<hills.size()) {
+      // bins touched by a chunk of consecutive hills
+      std::vector<Grid::index_t> neighbors;
+      std::vector<size_t> start(1,0);
+      size_t last=first;
+      do {
+        std::vector<unsigned> nneighb=getGaussianSupport(hills[last]);
+        std::vector<Grid::index_t> n=BiasGrid_->getNeighbors(hills[last].center,nneighb);
+        neighbors.insert(neighbors.end(),n.begin(),n.end());
+        start.push_back(neighbors.size());
+        last++;
+      } while(last<hills.size() && neighbors.size()<maxbins);
+      if(comm.Get_size()==1 && (neighbors.size()<2*nt || nt==1)) {
+        // for performance reasons and thread safety
+        std::vector<double> dp(ncv);
+        for(size_t h=first; h<last; ++h) {
+          for(size_t i=start[h-first]; i<start[h-first+1]; ++i) {
+            Grid::index_t ineigh=neighbors[i];
+            for(unsigned j=0; j<ncv; ++j) der[j]=0.0;
+            BiasGrid_->getPoint(ineigh,xx);
+            double bias=evaluateGaussianAndDerivatives(xx,hills[h],der,dp);
+            BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
+          }
+        }
+      } else {
+        unsigned stride=comm.Get_size();
+        unsigned rank=comm.Get_rank();
+        // index of the hill corresponding to each bin in the list
+        std::vector<unsigned> hill_index(neighbors.size());
+        for(size_t h=first; h<last; ++h) {
+          for(size_t i=start[h-first]; i<start[h-first+1]; ++i) hill_index[i]=h;
+        }
+        std::vector<double> allder(ncv*neighbors.size(),0.0);
+        std::vector<double> allbias(neighbors.size(),0.0);
+        // Gaussians are evaluated in parallel, both across processes and threads
+        #pragma omp parallel num_threads(nt)
+        {
+          std::vector<double> n_der(ncv,0.0);
+          std::vector<double> n_xx(ncv,0.0);
+          // for performance reasons and thread safety
+          std::vector<double> dp(ncv);
+          #pragma omp for
+          for(unsigned i=rank; i<neighbors.size(); i+=stride) {
+            Grid::index_t ineigh=neighbors[i];
+            for(unsigned j=0; j<ncv; ++j) n_der[j]=0.0;
+            BiasGrid_->getPoint(ineigh,n_xx);
+            allbias[i]=evaluateGaussianAndDerivatives(n_xx,hills[hill_index[i]],n_der,dp);
+            for(unsigned j=0; j<ncv; j++) allder[ncv*i+j]=n_der[j];
+          }
+        }
+        if(stride>1) {
+          comm.Sum(allbias);
+          comm.Sum(allder);
+        }
+        // the grid is updated serially, since the same bin might appear more than once
+        // in the list of neighbors and sparse grids cannot be updated concurrently.
+        // hills are added in order, so that the result does not depend on the chunking
+        for(unsigned i=0; i<neighbors.size(); ++i) {
+          Grid::index_t ineigh=neighbors[i];
+          for(unsigned j=0; j<ncv; ++j) der[j]=allder[ncv*i+j];
+          BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+        }
       }
+      first=last;
     }
-  } else hills_.push_back(hill);
+  } else hills_.insert(hills_.end(),hills.begin(),hills.end());
 }
 
 std::vector<unsigned> MetaD::getGaussianSupport(const Gaussian& hill)
@@ -1970,24 +2062,23 @@ void MetaD::update()
 
     // In case we use walkers_mpi, it is now necessary to communicate with other replicas.
     if(walkers_mpi_) {
-      // Allocate arrays to store all walkers hills
-      std::vector<double> all_cv(mpi_nw_*ncv,0.0);
-      std::vector<double> all_sigma(mpi_nw_*thissigma.size(),0.0);
-      std::vector<double> all_height(mpi_nw_,0.0);
-      std::vector<int>    all_multivariate(mpi_nw_,0);
+      // Each hill is packed as center, sigma, height and multivariate flag,
+      // so that hills from all walkers are gathered with a single collective
+      const unsigned nsigma=thissigma.size();
+      const unsigned packed=ncv+nsigma+2;
+      std::vector<double> all_hills(mpi_nw_*packed,0.0);
       if(comm.Get_rank()==0) {
-        // Communicate (only root)
-        multi_sim_comm.Allgather(cv,all_cv);
-        multi_sim_comm.Allgather(thissigma,all_sigma);
+        std::vector<double> my_hill(packed);
+        for(unsigned j=0; j<ncv; j++) my_hill[j]=cv[j];
+        for(unsigned j=0; j<nsigma; j++) my_hill[ncv+j]=thissigma[j];
         // notice that if gamma=1 we store directly -F so this scaling is not necessary:
-        multi_sim_comm.Allgather(height*(biasf_>1.0?biasf_/(biasf_-1.0):1.0),all_height);
-        multi_sim_comm.Allgather(int(multivariate),all_multivariate);
+        my_hill[ncv+nsigma]=height*(biasf_>1.0?biasf_/(biasf_-1.0):1.0);
+        my_hill[ncv+nsigma+1]=(multivariate?1.0:0.0);
+        // Communicate (only root)
+        multi_sim_comm.Allgather(my_hill,all_hills);
       }
       // Share info with group members
-      comm.Bcast(all_cv,0);
-      comm.Bcast(all_sigma,0);
-      comm.Bcast(all_height,0);
-      comm.Bcast(all_multivariate,0);
+      comm.Bcast(all_hills,0);
 
       // Flying Gaussian
       if (flying_) {
@@ -1995,18 +2086,19 @@ void MetaD::update()
         comm.Barrier();
       }
 
+      std::vector<Gaussian> newhills;
+      newhills.reserve(mpi_nw_);
       for(unsigned i=0; i<mpi_nw_; i++) {
-        // actually add hills one by one
-        std::vector<double> cv_now(ncv);
-        std::vector<double> sigma_now(thissigma.size());
-        for(unsigned j=0; j<ncv; j++) cv_now[j]=all_cv[i*ncv+j];
-        for(unsigned j=0; j<thissigma.size(); j++) sigma_now[j]=all_sigma[i*thissigma.size()+j];
+        const double* hill_now=&all_hills[i*packed];
+        std::vector<double> cv_now(hill_now,hill_now+ncv);
+        std::vector<double> sigma_now(hill_now+ncv,hill_now+ncv+nsigma);
         // notice that if gamma=1 we store directly -F so this scaling is not necessary:
         double fact=(biasf_>1.0?(biasf_-1.0)/biasf_:1.0);
-        Gaussian newhill=Gaussian(all_multivariate[i],all_height[i]*fact,cv_now,sigma_now);
-        addGaussian(newhill);
-        if(!flying_) writeGaussian(newhill,hillsOfile_);
+        newhills.push_back(Gaussian(hill_now[ncv+nsigma+1]>0.5,hill_now[ncv+nsigma]*fact,cv_now,sigma_now));
       }
+      // all hills are added in a single pass
+      addGaussians(newhills);
+      if(!flying_) for(const auto & h : newhills) writeGaussian(h,hillsOfile_);
     } else {
       Gaussian newhill=Gaussian(multivariate,height,cv,thissigma);
       addGaussian(newhill);
@@ -2128,28 +2220,13 @@ bool MetaD::scanOneHill(IFile* ifile, std::vector<Value>& tmpvalues, std::vector
     else if(sss=="false") multivariate=false;
     else plumed_merror("cannot parse multivariate = "+ sss);
     if(multivariate) {
-      sigma.resize(ncv*(ncv+1)/2);
-      Matrix<double> upper(ncv,ncv);
       Matrix<double> lower(ncv,ncv);
       for(unsigned i=0; i<ncv; i++) {
         for(unsigned j=0; j<ncv-i; j++) {
           ifile->scanField("sigma_"+getPntrToArgument(j+i)->getName()+"_"+getPntrToArgument(j)->getName(),lower(j+i,j));
-          upper(j,j+i)=lower(j+i,j);
-        }
-      }
-      Matrix<double> mymult(ncv,ncv);
-      Matrix<double> invmatrix(ncv,ncv);
-      mult(lower,upper,mymult);
-      // now invert and get the sigmas
-      Invert(mymult,invmatrix);
-      // put the sigmas in the usual order: upper diagonal (this time in normal form and not in band form)
-      unsigned k=0;
-      for(unsigned i=0; i<ncv; i++) {
-        for(unsigned j=i; j<ncv; j++) {
-          sigma[k]=invmatrix(i,j);
-          k++;
         }
       }
+      getMultivariateSigma(lower,sigma);
     } else {
       for(unsigned i=0; i<ncv; ++i) {
         ifile->scanField("sigma_"+getPntrToArgument(i)->getName(),sigma[i]);
@@ -2168,6 +2245,30 @@ bool MetaD::scanOneHill(IFile* ifile, std::vector<Value>& tmpvalues, std::vector
   }
 }
 
+void MetaD::getMultivariateSigma(const Matrix<double>& lower, std::vector<double>& sigma)
+{
+  // lower contains the band form written in the HILLS file
+  unsigned ncv=getNumberOfArguments();
+  sigma.resize(ncv*(ncv+1)/2);
+  Matrix<double> upper(ncv,ncv);
+  for(unsigned i=0; i<ncv; i++) {
+    for(unsigned j=0; j<ncv-i; j++) upper(j,j+i)=lower(j+i,j);
+  }
+  Matrix<double> mymult(ncv,ncv);
+  Matrix<double> invmatrix(ncv,ncv);
+  mult(lower,upper,mymult);
+  // now invert and get the sigmas
+  Invert(mymult,invmatrix);
+  // put the sigmas in the usual order: upper diagonal (this time in normal form and not in band form)
+  unsigned k=0;
+  for(unsigned i=0; i<ncv; i++) {
+    for(unsigned j=i; j<ncv; j++) {
+      sigma[k]=invmatrix(i,j);
+      k++;
+    }
+  }
+}
+
 void MetaD::computeReweightingFactor()
 {
   if(biasf_==1.0) { // in this case we have no bias, so reweight factor is 0.0
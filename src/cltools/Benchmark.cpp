@@ -0,0 +1,235 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2012-2022 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "CLTool.h"
+#include "CLToolRegister.h"
+#include "tools/Tools.h"
+#include "tools/Vector.h"
+#include "tools/Tensor.h"
+#include "tools/Random.h"
+#include "tools/Stopwatch.h"
+#include "tools/PlumedHandle.h"
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <sstream>
+
+namespace PLMD {
+namespace cltools {
+
+//+PLUMEDOC TOOLS benchmark
+/*
+benchmark is a tool that allows you to measure the time spent by PLUMED on a synthetic system.
+
+Atomic configurations are generated in memory, so that the measured time does not include
+the time needed to read a trajectory. The generated system is a cubic box with periodic
+boundary conditions containing the requested number of atoms. Atoms can be placed
+randomly (`gas`), on a simple cubic lattice (`lattice`) or grouped in randomly placed and oriented
+triplets with the geometry of a water molecule (`water`). The size of the box is chosen so as to match
+the requested density, which by default is that of liquid water (100 atoms per cubic nanometer).
+At every step all the atoms are randomly displaced by a small amount, so that
+neighbor lists and similar data structures are exercised in a realistic way.
+
+The input file is then used to run PLUMED for the requested number of steps and
+the time spent in each step is reported at the end, together with the time
+spent in initializing PLUMED. Times are in seconds.
+
+Several kernels can be compared side by side passing a comma separated list of
+paths to `--kernel`. The special name `this` refers to the kernel the tool belongs to.
+All the kernels are run on exactly the same configurations, alternating them step by step
+so that fluctuations in the load of the machine affect them in the same way.
+Each kernel writes its log on a separate file, and the ratio between the time
+spent in calculation by each kernel and by the first one is reported at the end.
+Notice that files written by the input (e.g. by \ref PRINT) are shared among kernels,
+so that, when comparing multiple kernels, the input should better not write any file.
+
+\par Examples
+
+The following command measures the time spent by the current kernel on
+1000 steps of a system with 5000 atoms in a liquid-water-like arrangement:
+\verbatim
+plumed benchmark --plumed plumed.dat --natoms 5000 --nsteps 1000 --atom-distribution water
+\endverbatim
+
+The following command compares the current kernel with another one:
+\verbatim
+plumed benchmark --plumed plumed.dat --kernel this,/path/to/libplumedKernel.so
+\endverbatim
+
+*/
+//+ENDPLUMEDOC
+
+class Benchmark:
+  public CLTool
+{
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit Benchmark(const CLToolOptions& co );
+  int main(FILE* in, FILE*out,Communicator& pc) override;
+  std::string description()const override {
+    return "run a calculation on synthetic configurations and report timings";
+  }
+};
+
+PLUMED_REGISTER_CLTOOL(Benchmark,"benchmark")
+
+void Benchmark::registerKeywords( Keywords& keys ) {
+  CLTool::registerKeywords( keys );
+  keys.add("compulsory","--plumed","plumed.dat","specify the name of the plumed input file");
+  keys.add("compulsory","--kernel","this","comma separated list of paths to the kernels to be compared. this refers to the current kernel");
+  keys.add("compulsory","--natoms","1000","the number of atoms in the system");
+  keys.add("compulsory","--nsteps","100","the number of steps to be run");
+  keys.add("compulsory","--atom-distribution","gas","the way atoms are placed in the box: gas, lattice or water");
+  keys.add("compulsory","--density","100.0","the number of atoms per cubic nanometer, by default roughly that of liquid water");
+  keys.add("compulsory","--displacement","0.01","the maximum displacement of each atom at each step, in nm");
+  keys.add("compulsory","--timestep","0.002","the timestep, in ps");
+  keys.add("compulsory","--seed","1","the seed for the random number generator");
+  keys.add("compulsory","--log","benchmark.log","the name of the log file. When multiple kernels are used, a suffix with the index of the kernel is added");
+}
+
+Benchmark::Benchmark(const CLToolOptions& co ):
+  CLTool(co)
+{
+  inputdata=commandline;
+}
+
+int Benchmark::main(FILE* in, FILE*out,Communicator& pc) {
+
+  std::string plumedFile; parse("--plumed",plumedFile);
+  std::string kernelList; parse("--kernel",kernelList);
+  int natoms; parse("--natoms",natoms);
+  int nsteps; parse("--nsteps",nsteps);
+  std::string distribution; parse("--atom-distribution",distribution);
+  double density; parse("--density",density);
+  double displacement; parse("--displacement",displacement);
+  int seed; parse("--seed",seed);
+  std::string logFile; parse("--log",logFile);
+  double timestep; parse("--timestep",timestep);
+
+  if(natoms<=0) error("--natoms should be positive");
+  if(nsteps<0) error("--nsteps should not be negative");
+  if(density<=0.0) error("--density should be positive");
+  if(distribution!="gas" && distribution!="lattice" && distribution!="water") error("unknown atom distribution " + distribution);
+  if(distribution=="water" && natoms%3!=0) error("with --atom-distribution water the number of atoms should be a multiple of 3");
+
+  std::vector<std::string> kernels=Tools::getWords(kernelList,",");
+  if(kernels.size()==0) error("at least one kernel should be specified");
+
+  const double side=std::cbrt(natoms/density);
+  Tensor box;
+  box(0,0)=box(1,1)=box(2,2)=side;
+
+  Random random;
+  random.setSeed(-seed);
+
+  std::vector<Vector> positions(natoms);
+  if(distribution=="gas") {
+    for(auto & p : positions) p=side*Vector(random.RandU01(),random.RandU01(),random.RandU01());
+  } else if(distribution=="lattice") {
+    unsigned n=1;
+    while(n*n*n<unsigned(natoms)) n++;
+    const double spacing=side/n;
+    for(unsigned i=0; i<positions.size(); i++) {
+      positions[i]=spacing*Vector(i%n+0.5,(i/n)%n+0.5,i/(n*n)+0.5);
+    }
+  } else if(distribution=="water") {
+// O-H distance and H-O-H angle of a water molecule
+    const double bond=0.1;
+    const double angle=104.5*pi/180.0;
+    for(unsigned i=0; i<positions.size(); i+=3) {
+      const Vector oxygen=side*Vector(random.RandU01(),random.RandU01(),random.RandU01());
+// random orientation, obtained from two random orthogonal unit vectors
+      Vector u(random.Gaussian(),random.Gaussian(),random.Gaussian());
+      u/=u.modulo();
+      Vector v(random.Gaussian(),random.Gaussian(),random.Gaussian());
+      v-=dotProduct(u,v)*u;
+      v/=v.modulo();
+      positions[i]=oxygen;
+      positions[i+1]=oxygen+bond*u;
+      positions[i+2]=oxygen+bond*(std::cos(angle)*u+std::sin(angle)*v);
+    }
+  }
+
+  std::vector<double> masses(natoms,1.0);
+  std::vector<double> charges(natoms,0.0);
+  std::vector<Vector> forces(natoms);
+  Tensor virial;
+
+  Stopwatch sw;
+  std::vector<std::string> names(kernels.size());
+  std::vector<PlumedHandle> handles;
+  for(unsigned k=0; k<kernels.size(); k++) {
+    names[k]="kernel " + std::to_string(k);
+    std::fprintf(out,"Using %s: %s\n",names[k].c_str(),kernels[k].c_str());
+    auto sww=sw.startStop(names[k]+" init");
+    if(kernels[k]=="this") handles.emplace_back(PlumedHandle());
+    else handles.emplace_back(PlumedHandle::dlopen(kernels[k].c_str()));
+    auto & p(handles.back());
+    std::string log=logFile;
+    if(kernels.size()>1) log+="." + std::to_string(k);
+    int precision=sizeof(double);
+    p.cmd("setRealPrecision",&precision);
+    p.cmd("setNatoms",&natoms);
+    p.cmd("setMDEngine","benchmark");
+    p.cmd("setTimestep",&timestep);
+    p.cmd("setPlumedDat",plumedFile.c_str());
+    p.cmd("setLogFile",log.c_str());
+    p.cmd("init");
+  }
+
+  for(int step=0; step<nsteps; step++) {
+    if(step>0) for(auto & p : positions) p+=displacement*Vector(2.0*random.RandU01()-1.0,2.0*random.RandU01()-1.0,2.0*random.RandU01()-1.0);
+    for(unsigned k=0; k<handles.size(); k++) {
+      auto & p(handles[k]);
+      for(auto & f : forces) f.zero();
+      virial.zero();
+      auto sww=sw.startStop(names[k]+" calc");
+      p.cmd("setStep",&step);
+      p.cmd("setBox",&box[0][0]);
+      p.cmd("setMasses",&masses[0]);
+      p.cmd("setCharges",&charges[0]);
+      p.cmd("setPositions",&positions[0][0]);
+      p.cmd("setForces",&forces[0][0]);
+      p.cmd("setVirial",&virial[0][0]);
+      p.cmd("calc");
+    }
+  }
+
+// finalize kernels before reporting timings, so that their logs are complete
+  handles.clear();
+
+  std::ostringstream ostr;
+  ostr<<sw;
+  std::fprintf(out,"\nTimings (seconds) for %d atoms (%s, box side %f nm) and %d steps:\n%s",natoms,distribution.c_str(),side,nsteps,ostr.str().c_str());
+
+  if(kernels.size()>1 && nsteps>0) {
+    std::fprintf(out,"\nCalculation time relative to kernel 0:\n");
+    const double reference=sw.getTotal(names[0]+" calc");
+    for(unsigned k=0; k<kernels.size(); k++) {
+      std::fprintf(out,"%s %f\n",names[k].c_str(),sw.getTotal(names[k]+" calc")/reference);
+    }
+  }
+  return 0;
+}
+
+} // End of namespace
+}
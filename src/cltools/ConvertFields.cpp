@@ -0,0 +1,140 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2012-2022 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "CLTool.h"
+#include "CLToolRegister.h"
+#include "tools/Tools.h"
+#include "tools/IFile.h"
+#include "tools/OFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace PLMD {
+namespace cltools {
+
+//+PLUMEDOC TOOLS convert_fields
+/*
+convert_fields can be used to convert files with fields between the text and the binary format.
+
+Files with fields (e.g. the grids written with GRID_WFILE by \ref METAD, the states written with
+STATE_WFILE by \ref OPES_METAD, the coefficients of VES biases or the STATUS_FILE of \ref EMMI)
+are written in a binary format when their name has extension `pbin`.
+Binary files store doubles exactly and are faster to write and read, and
+they can be read back by the same actions exactly as the corresponding text files.
+The binary format is portable across machines with different byte order.
+
+This tool reads a file in either format and writes it in the format implied by the
+name of the output file, that is in binary format if its extension is `pbin`
+and in text format otherwise.
+The names of the fields and the constant fields written in the headers are preserved.
+When converting a text file to binary format, fields containing numbers are stored as doubles,
+whereas all the other fields are stored as text.
+When converting a binary file to text format, doubles are written with all the digits needed to read them back exactly.
+Empty lines and comments of text files are not preserved.
+
+\par Examples
+
+The following command converts a binary grid to text format, so that it can be plotted:
+\verbatim
+plumed convert_fields --ifile grid.pbin --ofile grid.dat
+\endverbatim
+
+The following command converts a text grid to binary format, so that it can be used to restart a simulation:
+\verbatim
+plumed convert_fields --ifile grid.dat --ofile grid.pbin
+\endverbatim
+
+*/
+//+ENDPLUMEDOC
+
+class ConvertFields:
+  public CLTool
+{
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit ConvertFields(const CLToolOptions& co );
+  int main(FILE* in, FILE*out,Communicator& pc) override;
+  std::string description()const override {
+    return "convert files with fields between the text and the binary format";
+  }
+};
+
+PLUMED_REGISTER_CLTOOL(ConvertFields,"convert_fields")
+
+void ConvertFields::registerKeywords( Keywords& keys ) {
+  CLTool::registerKeywords( keys );
+  keys.add("compulsory","--ifile","specify the name of the input file");
+  keys.add("compulsory","--ofile","specify the name of the output file, which is written in binary format if its extension is pbin");
+}
+
+ConvertFields::ConvertFields(const CLToolOptions& co ):
+  CLTool(co)
+{
+  inputdata=commandline;
+}
+
+/// Check if a value should be stored as a double in a binary file
+static bool isDouble(const std::string & str,double & x) {
+  char* end;
+  x=std::strtod(str.c_str(),&end);
+  return end!=str.c_str() && *end=='\0';
+}
+
+int ConvertFields::main(FILE* in, FILE*out,Communicator& pc) {
+  std::string ifilename; parse("--ifile",ifilename);
+  std::string ofilename; parse("--ofile",ofilename);
+
+  IFile ifile;
+  ifile.open(ifilename);
+  OFile ofile;
+  ofile.open(ofilename);
+
+  std::vector<std::string> fields;
+  std::vector<std::string> previous;
+  std::vector<std::string> columns;
+  std::string value;
+  double x;
+  while(ifile.scanFieldList(fields)) {
+    ifile.getColumnList(columns);
+// a new header is written whenever the list of fields changes
+    if(fields!=previous) {
+      ofile.clearFields();
+      for(const auto & f : fields) if(std::find(columns.begin(),columns.end(),f)==columns.end()) ofile.addConstantField(f);
+      previous=fields;
+    }
+// constant fields are always written as text, other fields are separated by a space
+    for(const auto & f : fields) {
+      ifile.scanField(f,value);
+      if(std::find(columns.begin(),columns.end(),f)==columns.end()) ofile.printField(f,value);
+      else if(ofile.isBinary() && isDouble(value,x)) ofile.printField(f,x);
+      else ofile.printField(f," "+value);
+    }
+    ifile.scanField();
+    ofile.printField();
+  }
+  return 0;
+}
+
+} // End of namespace
+}
@@ -85,6 +85,7 @@ public:
   explicit Angle(const ActionOptions&);
 // active methods:
   void calculate() override;
+  bool canRunConcurrently() const override { return true; }
   static void registerKeywords( Keywords& keys );
 };
 
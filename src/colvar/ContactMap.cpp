@@ -171,7 +171,11 @@ ContactMap::ContactMap(const ActionOptions&ao):
 
     // Add a value for this contact
     std::string num; Tools::convert(i,num);
-    if(!dosum&&!docmdist) {addComponentWithDerivatives("contact-"+num); componentIsNotPeriodic("contact-"+num);}
+    if(!dosum&&!docmdist) {
+      addComponentWithDerivatives("contact-"+num); componentIsNotPeriodic("contact-"+num);
+// each component only depends on two atoms
+      getPntrToComponent("contact-"+num)->setSparseDerivatives(true);
+    }
   }
   // Create neighbour lists
   nl=Tools::make_unique<NeighborList>(ga_lista,gb_lista,serial,true,pbc,getPbc(),comm);
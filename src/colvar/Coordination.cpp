@@ -62,6 +62,14 @@ The following example instructs plumed to calculate the total coordination numbe
 COORDINATION GROUPA=1-10 GROUPB=20-100 R_0=0.3 NLIST NL_CUTOFF=0.5 NL_STRIDE=100
 \endplumedfile
 
+Instead of updating the neighbor list with a fixed stride, you can use NL_SKIN.
+In this case the neighbor list includes all the pairs within NL_CUTOFF+NL_SKIN and it is
+updated only when one of the atoms has moved by more than half of NL_SKIN since the last update.
+Notice that with this option the positions of all the atoms are retrieved at every step.
+\plumedfile
+COORDINATION GROUPA=1-10 GROUPB=20-100 R_0=0.3 NLIST NL_CUTOFF=0.5 NL_SKIN=0.1
+\endplumedfile
+
 The following is a dummy example which should compute the value 0 because the self interaction
 of atom 1 is skipped. Notice that in plumed 2.0 "self interactions" were not skipped, and the
 same calculation should return 1.
@@ -100,6 +108,7 @@ public:
 // active methods:
   static void registerKeywords( Keywords& keys );
   double pairing(double distance,double&dfunc,unsigned i,unsigned j)const override;
+  void pairingBlock(unsigned n,const double* distance2,double* value,double* dfunc,const unsigned* i,const unsigned* j)const override;
 };
 
 PLUMED_REGISTER_ACTION(Coordination,"COORDINATION")
@@ -149,6 +158,12 @@ double Coordination::pairing(double distance,double&dfunc,unsigned i,unsigned j)
   return switchingFunction.calculateSqr(distance,dfunc);
 }
 
+void Coordination::pairingBlock(unsigned n,const double* distance2,double* value,double* dfunc,const unsigned* i,const unsigned* j)const {
+  (void) i; // avoid warnings
+  (void) j; // avoid warnings
+  switchingFunction.calculateSqr(distance2,value,dfunc,n);
+}
+
 }
 
 }
@@ -23,6 +23,7 @@
 #include "tools/NeighborList.h"
 #include "tools/Communicator.h"
 #include "tools/OpenMP.h"
+#include <algorithm>
 
 namespace PLMD {
 namespace colvar {
@@ -34,6 +35,8 @@ void CoordinationBase::registerKeywords( Keywords& keys ) {
   keys.addFlag("NLIST",false,"Use a neighbor list to speed up the calculation");
   keys.add("optional","NL_CUTOFF","The cutoff for the neighbor list");
   keys.add("optional","NL_STRIDE","The frequency with which we are updating the atoms in the neighbor list");
+  keys.add("optional","NL_SKIN","The skin of the neighbor list. If present, the neighbor list is updated only when an atom has moved by more than half the skin or the box has changed");
+  keys.addFlag("NL_ALLPAIRS",false,"Rebuild the neighbor list looping over all the pairs rather than using link cells - for debug purpose");
   keys.add("atoms","GROUPA","First list of atoms");
   keys.add("atoms","GROUPB","Second list of atoms (if empty, N*(N-1)/2 pairs in GROUPA are counted)");
 }
@@ -43,7 +46,8 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   pbc(true),
   serial(false),
   invalidateList(true),
-  firsttime(true)
+  firsttime(true),
+  skin(0.0)
 {
 
   parseFlag("SERIAL",serial);
@@ -64,12 +68,21 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   bool doneigh=false;
   double nl_cut=0.0;
   int nl_st=0;
+  bool nl_allpairs=false;
   parseFlag("NLIST",doneigh);
   if(doneigh) {
     parse("NL_CUTOFF",nl_cut);
     if(nl_cut<=0.0) error("NL_CUTOFF should be explicitly specified and positive");
+    parse("NL_SKIN",skin);
+    if(skin<0.0) error("NL_SKIN should be positive");
     parse("NL_STRIDE",nl_st);
-    if(nl_st<=0) error("NL_STRIDE should be explicitly specified and positive");
+    if(skin>0.0) {
+      if(nl_st>0) error("NL_STRIDE and NL_SKIN cannot be used together");
+// positions are checked at every step
+      nl_st=1;
+      nl_cut+=skin;
+    } else if(nl_st<=0) error("NL_STRIDE should be explicitly specified and positive");
+    parseFlag("NL_ALLPAIRS",nl_allpairs);
   }
 
   addValueWithDerivatives(); setNotPeriodic();
@@ -80,6 +93,7 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
     if(doneigh)  nl=Tools::make_unique<NeighborList>(ga_lista,serial,pbc,getPbc(),comm,nl_cut,nl_st);
     else         nl=Tools::make_unique<NeighborList>(ga_lista,serial,pbc,getPbc(),comm);
   }
+  nl->setLinkCells(!nl_allpairs);
 
   requestAtoms(nl->getFullAtomList());
 
@@ -100,7 +114,9 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   if(dopair) log.printf("  with PAIR option\n");
   if(doneigh) {
     log.printf("  using neighbor lists with\n");
-    log.printf("  update every %d steps and cutoff %f\n",nl_st,nl_cut);
+    if(skin>0.0) log.printf("  cutoff %f including a skin %f, updated when an atom moves by more than half the skin\n",nl_cut,skin);
+    else log.printf("  update every %d steps and cutoff %f\n",nl_st,nl_cut);
+    if(nl_allpairs) log.printf("  rebuilding the neighbor list looping over all pairs\n");
   }
 }
 
@@ -109,7 +125,12 @@ CoordinationBase::~CoordinationBase() {
 }
 
 void CoordinationBase::prepare() {
-  if(nl->getStride()>0) {
+  if(nl->getStride()>0 && skin>0.0) {
+// the full list of atoms is always requested since all the displacements are needed,
+// the list is updated in calculate() if needed
+    invalidateList=firsttime || getExchangeStep();
+    firsttime=getExchangeStep();
+  } else if(nl->getStride()>0) {
     if(firsttime || (getStep()%nl->getStride()==0)) {
       requestAtoms(nl->getFullAtomList());
       invalidateList=true;
@@ -123,6 +144,27 @@ void CoordinationBase::prepare() {
   }
 }
 
+bool CoordinationBase::skinExceeded() const {
+// the displacement of the periodic images due to a change of the box is not bounded
+// by the skin, so the list is updated whenever the box changes
+  if(pbc) {
+    const Tensor & box=getBox();
+    for(unsigned i=0; i<3; ++i) for(unsigned j=0; j<3; ++j) if(box(i,j)!=referenceBox(i,j)) return true;
+  }
+  const double maxdisp2=0.25*skin*skin;
+  for(unsigned i=0; i<getNumberOfAtoms(); ++i) {
+    Vector displacement;
+    if(pbc) displacement=pbcDistance(reference[i],getPosition(i));
+    else    displacement=delta(reference[i],getPosition(i));
+    if(modulo2(displacement)>maxdisp2) return true;
+  }
+  return false;
+}
+
+void CoordinationBase::pairingBlock(unsigned n,const double* distance2,double* value,double* dfunc,const unsigned* i,const unsigned* j)const {
+  for(unsigned k=0; k<n; k++) value[k]=pairing(distance2[k],dfunc[k],i[k],j[k]);
+}
+
 // calculator
 void CoordinationBase::calculate()
 {
@@ -131,8 +173,15 @@ void CoordinationBase::calculate()
   Tensor virial;
   std::vector<Vector> deriv(getNumberOfAtoms());
 
-  if(nl->getStride()>0 && invalidateList) {
-    nl->update(getPositions());
+  if(nl->getStride()>0) {
+    if(skin>0.0 && !invalidateList) invalidateList=skinExceeded();
+    if(invalidateList) {
+      nl->update(getPositions());
+      if(skin>0.0) {
+        reference=getPositions();
+        referenceBox=getBox();
+      }
+    }
   }
 
   unsigned stride;
@@ -149,39 +198,57 @@ void CoordinationBase::calculate()
   const unsigned nn=nl->size();
   if(nt*stride*10>nn) nt=1;
 
+// pairs are processed in blocks, so that pairingBlock() can work on contiguous arrays
+  const unsigned blocksize=64;
+  const unsigned nlocal=(nn>rank ? (nn-rank+stride-1)/stride : 0);
+
   #pragma omp parallel num_threads(nt)
   {
     std::vector<Vector> omp_deriv(getPositions().size());
     Tensor omp_virial;
+    std::vector<Vector> distances(blocksize);
+    std::vector<double> distances2(blocksize),values(blocksize),dfuncs(blocksize);
+    std::vector<unsigned> first(blocksize),second(blocksize);
 
     #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
-
-      Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
-
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
-
-      if(pbc) {
-        distance=pbcDistance(getPosition(i0),getPosition(i1));
-      } else {
-        distance=delta(getPosition(i0),getPosition(i1));
+    for(unsigned int ib=0; ib<nlocal; ib+=blocksize) {
+
+      const unsigned iend=std::min(ib+blocksize,nlocal);
+      unsigned npairs=0;
+      for(unsigned k=ib; k<iend; k++) {
+        const unsigned i=rank+k*stride;
+        unsigned i0=nl->getClosePair(i).first;
+        unsigned i1=nl->getClosePair(i).second;
+
+        if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+
+        if(pbc) {
+          distances[npairs]=pbcDistance(getPosition(i0),getPosition(i1));
+        } else {
+          distances[npairs]=delta(getPosition(i0),getPosition(i1));
+        }
+        distances2[npairs]=distances[npairs].modulo2();
+        first[npairs]=i0;
+        second[npairs]=i1;
+        npairs++;
       }
 
-      double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
-
-      Vector dd(dfunc*distance);
-      Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
-        omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
+      pairingBlock(npairs,distances2.data(),values.data(),dfuncs.data(),first.data(),second.data());
+
+      for(unsigned k=0; k<npairs; k++) {
+        ncoord += values[k];
+
+        Vector dd(dfuncs[k]*distances[k]);
+        Tensor vv(dd,distances[k]);
+        if(nt>1) {
+          omp_deriv[first[k]]-=dd;
+          omp_deriv[second[k]]+=dd;
+          omp_virial-=vv;
+        } else {
+          deriv[first[k]]-=dd;
+          deriv[second[k]]+=dd;
+          virial-=vv;
+        }
       }
 
     }
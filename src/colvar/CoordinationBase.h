@@ -23,6 +23,7 @@
 #define __PLUMED_colvar_CoordinationBase_h
 #include "Colvar.h"
 #include <memory>
+#include <vector>
 
 namespace PLMD {
 
@@ -36,6 +37,14 @@ class CoordinationBase : public Colvar {
   std::unique_ptr<NeighborList> nl;
   bool invalidateList;
   bool firsttime;
+/// Skin of the neighbor list, zero if the list is updated with a fixed stride
+  double skin;
+/// Positions of the atoms when the neighbor list was last updated
+  std::vector<Vector> reference;
+/// Box when the neighbor list was last updated
+  Tensor referenceBox;
+/// Check if any atom moved by more than half the skin or the box changed since the last update
+  bool skinExceeded() const;
 
 public:
   explicit CoordinationBase(const ActionOptions&);
@@ -44,6 +53,8 @@ public:
   void calculate() override;
   void prepare() override;
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const=0;
+/// Compute pairing() on a block of n pairs. Can be overridden when a faster implementation is available
+  virtual void pairingBlock(unsigned n,const double* distance2,double* value,double* dfunc,const unsigned* i,const unsigned* j)const;
   static void registerKeywords( Keywords& keys );
 };
 
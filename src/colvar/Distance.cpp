@@ -113,6 +113,7 @@ public:
   explicit Distance(const ActionOptions&);
 // active methods:
   void calculate() override;
+  bool canRunConcurrently() const override { return true; }
 };
 
 PLUMED_REGISTER_ACTION(Distance,"DISTANCE")
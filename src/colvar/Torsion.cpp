@@ -94,6 +94,7 @@ public:
   explicit Torsion(const ActionOptions&);
 // active methods:
   void calculate() override;
+  bool canRunConcurrently() const override { return true; }
   static void registerKeywords(Keywords& keys);
 };
 
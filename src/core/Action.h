@@ -261,6 +261,11 @@ public:
 /// Check if numerical derivatives should be performed
   virtual bool checkNumericalDerivatives()const {return false;}
 
+/// Check if calculate() and apply() can be run concurrently with those of other
+/// independent actions. This is only allowed for actions that do not communicate
+/// and do not modify any state shared with other actions
+  virtual bool canRunConcurrently()const {return false;}
+
 /// Check if the action needs gradient
   virtual bool checkNeedsGradients()const {return false;}
 
@@ -100,6 +100,7 @@ void Atoms::startStep() {
   collectEnergy=false; energyHasBeenSet=false; positionsHaveBeenSet=0;
   massesHaveBeenSet=false; chargesHaveBeenSet=false; boxHasBeenSet=false;
   forcesHaveBeenSet=0; virialHasBeenSet=false; dataCanBeSet=true;
+  linkCellsCache.clear();
 }
 
 void Atoms::setBox(const TypesafePtr & p) {
@@ -271,6 +272,25 @@ void Atoms::share(const std::vector<AtomNumber>& unique) {
       for(unsigned i=0; i<dd.mpi_request_index.size(); i++)     dd.mpi_request_index[i].wait();
     }
     int count=0;
+// in collective mode, counts and change flags from all the processes are gathered
+// while the positions are copied in the buffer.
+// indexes are gathered again only if some process changed its list of atoms
+    int local[2];
+    std::vector<int> all;
+    Communicator::Request countsRequest;
+    if(dd.collective) {
+      int changed=(int(unique.size())!=dd.collectiveCount);
+      for(const auto & p : unique) {
+        if(!changed && dd.indexToBeSent[count]!=int(p.index())) changed=1;
+        dd.indexToBeSent[count]=p.index();
+        count++;
+      }
+      local[0]=count;
+      local[1]=changed;
+      all.resize(2*dd.Get_size());
+      countsRequest=dd.Iallgather(&local[0],2,&all[0],2);
+      count=0;
+    }
     for(const auto & p : unique) {
       dd.indexToBeSent[count]=p.index();
       dd.positionsToBeSent[ndata*count+0]=positions[p.index()][0];
@@ -282,7 +302,31 @@ void Atoms::share(const std::vector<AtomNumber>& unique) {
       }
       count++;
     }
-    if(dd.async) {
+    if(dd.collective) {
+      const int n=(dd.Get_size());
+      countsRequest.wait();
+      dd.collectiveCounts.resize(n);
+      dd.collectiveDispl.resize(n);
+      dd.collectiveCountsData.resize(n);
+      dd.collectiveDisplData.resize(n);
+      dd.collectiveIndex=false;
+      for(int i=0; i<n; ++i) {
+        dd.collectiveCounts[i]=all[2*i];
+        if(all[2*i+1]) dd.collectiveIndex=true;
+      }
+      dd.collectiveDispl[0]=0;
+      for(int i=1; i<n; ++i) dd.collectiveDispl[i]=dd.collectiveDispl[i-1]+dd.collectiveCounts[i-1];
+      for(int i=0; i<n; ++i) dd.collectiveCountsData[i]=dd.collectiveCounts[i]*ndata;
+      for(int i=0; i<n; ++i) dd.collectiveDisplData[i]=dd.collectiveDispl[i]*ndata;
+      if(dd.collectiveIndex) {
+        dd.mpi_request_index.resize(1);
+        dd.mpi_request_index[0]=dd.Iallgatherv(&dd.indexToBeSent[0],count,&dd.indexToBeReceived[0],&dd.collectiveCounts[0],&dd.collectiveDispl[0]);
+      }
+      dd.mpi_request_positions.resize(1);
+      dd.mpi_request_positions[0]=dd.Iallgatherv(&dd.positionsToBeSent[0],ndata*count,&dd.positionsToBeReceived[0],&dd.collectiveCountsData[0],&dd.collectiveDisplData[0]);
+      dd.collectiveCount=count;
+      asyncSent=true;
+    } else if(dd.async) {
       asyncSent=true;
       dd.mpi_request_positions.resize(dd.Get_size());
       dd.mpi_request_index.resize(dd.Get_size());
@@ -333,13 +377,22 @@ void Atoms::wait() {
   if(dd && shuffledAtoms>0) {
 // receive toBeReceived
     if(asyncSent) {
-      Communicator::Status status;
       std::size_t count=0;
-      for(int i=0; i<dd.Get_size(); i++) {
-        dd.Recv(&dd.indexToBeReceived[count],dd.indexToBeReceived.size()-count,i,666,status);
-        int c=status.Get_count<int>();
-        dd.Recv(&dd.positionsToBeReceived[ndata*count],dd.positionsToBeReceived.size()-ndata*count,i,667);
-        count+=c;
+      if(dd.collective) {
+// complete the communications started in share().
+// if indexes were not sent, the ones received last time are still valid
+        if(dd.collectiveIndex) dd.mpi_request_index[0].wait();
+        dd.mpi_request_positions[0].wait();
+        const int n=dd.Get_size();
+        count=dd.collectiveDispl[n-1]+dd.collectiveCounts[n-1];
+      } else {
+        Communicator::Status status;
+        for(int i=0; i<dd.Get_size(); i++) {
+          dd.Recv(&dd.indexToBeReceived[count],dd.indexToBeReceived.size()-count,i,666,status);
+          int c=status.Get_count<int>();
+          dd.Recv(&dd.positionsToBeReceived[ndata*count],dd.positionsToBeReceived.size()-ndata*count,i,667);
+          count+=c;
+        }
       }
       for(int i=0; i<count; i++) {
         positions[dd.indexToBeReceived[i]][0]=dd.positionsToBeReceived[ndata*i+0];
@@ -401,11 +454,16 @@ void Atoms::DomainDecomposition::enable(Communicator& c) {
   on=true;
   Set_comm(c.Get_comm());
   async=Get_size()<10;
+  collective=false;
   if(std::getenv("PLUMED_ASYNC_SHARE")) {
     std::string s(std::getenv("PLUMED_ASYNC_SHARE"));
     if(s=="yes") async=true;
     else if(s=="no") async=false;
-    else plumed_merror("PLUMED_ASYNC_SHARE variable is set to " + s + "; should be yes or no");
+// non-blocking collectives, completed in Atoms::wait()
+    else if(s=="collective") {
+      async=false;
+      collective=true;
+    } else plumed_merror("PLUMED_ASYNC_SHARE variable is set to " + s + "; should be yes, no or collective");
   }
 }
 
@@ -29,6 +29,7 @@
 #include "tools/Exception.h"
 #include "tools/AtomNumber.h"
 #include "tools/ForwardDecl.h"
+#include "tools/LinkCellsCache.h"
 #include <vector>
 #include <map>
 #include <string>
@@ -116,23 +117,40 @@ class Atoms
   bool asyncSent;
   bool atomsNeeded;
 
+/// Link cells built during this step, shared among actions
+  LinkCellsCache linkCellsCache;
+
   class DomainDecomposition:
     public Communicator
   {
   public:
     bool on;
     bool async;
+/// Use non-blocking collectives, posted in share() and completed in wait()
+    bool collective;
 
     std::vector<Communicator::Request> mpi_request_positions;
     std::vector<Communicator::Request> mpi_request_index;
 
+/// Number of atoms sent by this process in the last collective communication (-1 if none)
+    int collectiveCount;
+/// True if the indexes are being gathered in the current collective communication
+    bool collectiveIndex;
+/// Counts and displacements for collective communications.
+/// They are kept here since they should stay valid until the communication is completed.
+    std::vector<int> collectiveCounts;
+    std::vector<int> collectiveDispl;
+    std::vector<int> collectiveCountsData;
+    std::vector<int> collectiveDisplData;
+
     std::vector<double> positionsToBeSent;
     std::vector<double> positionsToBeReceived;
     std::vector<int>    indexToBeSent;
     std::vector<int>    indexToBeReceived;
     operator bool() const {return on;}
     DomainDecomposition():
-      on(false), async(false)
+      on(false), async(false), collective(false),
+      collectiveCount(-1), collectiveIndex(false)
     {}
     void enable(Communicator& c);
   };
@@ -170,6 +188,7 @@ public:
   const long long int& getDdStep()const;
   const std::vector<int>& getGatindex()const;
   const Pbc& getPbc()const;
+  LinkCellsCache& getLinkCellsCache();
   void getLocalMasses(std::vector<double>&);
   void getLocalPositions(std::vector<Vector>&);
   void getLocalForces(std::vector<Vector>&);
@@ -265,6 +284,11 @@ const Pbc& Atoms::getPbc()const {
   return pbc;
 }
 
+inline
+LinkCellsCache& Atoms::getLinkCellsCache() {
+  return linkCellsCache;
+}
+
 inline
 bool Atoms::isVirtualAtom(AtomNumber i)const {
   return i.index()>=(unsigned) getNatoms();
@@ -75,7 +75,17 @@ void Colvar::apply() {
       std::vector<double> forces(3*nat+9);
       #pragma omp for
       for(unsigned i=rank; i<ncp; i+=stride) {
-        if(getPntrToComponent(i)->applyForce(forces)) {
+        const Value* val=getPntrToComponent(i);
+        if(val->hasSparseDerivatives()) {
+// only loop over the derivatives that have been set
+          const double f=val->getForce();
+          if(f==0.0) continue;
+          for(unsigned k=0; k<val->getNumberOfActiveDerivatives(); ++k) {
+            const unsigned j=val->getActiveDerivativeIndex(k);
+            if(j<3*nat) omp_f[j/3][j%3]+=f*val->getDerivative(j);
+            else omp_v((j-3*nat)/3,(j-3*nat)%3)+=f*val->getDerivative(j);
+          }
+        } else if(getPntrToComponent(i)->applyForce(forces)) {
           for(unsigned j=0; j<nat; ++j) {
             omp_f[j][0]+=forces[3*j+0];
             omp_f[j][1]+=forces[3*j+1];
@@ -37,6 +37,7 @@
 #include "tools/Exception.h"
 #include "tools/IFile.h"
 #include "tools/Log.h"
+#include "tools/AsyncWriter.h"
 #include "tools/OpenMP.h"
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
@@ -210,6 +211,7 @@ PlumedMain::PlumedMain():
   stopNow(false),
   novirial(false),
   detailedTimers(false),
+  concurrentActions(false),
   gpuDeviceId(-1)
 {
   increaseReferenceCounter();
@@ -717,6 +719,13 @@ void PlumedMain::init() {
   log.printf("Number of atoms: %d\n",atoms.getNatoms());
   if(grex) log.printf("GROMACS-like replica exchange is on\n");
   log.printf("File suffix: %s\n",getSuffix().c_str());
+  if(std::getenv("PLUMED_ASYNC_OUTPUT")) {
+    std::string s(std::getenv("PLUMED_ASYNC_OUTPUT"));
+// at most 64 MB of data wait to be written
+    if(s=="yes") asyncWriter=Tools::make_unique<AsyncWriter>(64*1024*1024);
+    else if(s!="no") plumed_merror("PLUMED_ASYNC_OUTPUT variable is set to " + s + "; should be yes or no");
+  }
+  if(asyncWriter) log.printf("Files are written in background\n");
   if(plumedDat.length()>0) {
     readInputFile(plumedDat);
     plumedDat="";
@@ -921,50 +930,130 @@ void PlumedMain::justCalculate() {
   bias=0.0;
   work=0.0;
 
+  const bool concurrent=useConcurrentActions();
+// consecutive independent actions that can run concurrently
+  std::vector<Action*> batch;
+
   int iaction=0;
 // calculate the active actions in order (assuming *backward* dependence)
   for(const auto & pp : actionSet) {
     Action* p(pp.get());
+    if(concurrent && p->isActive() && p->canRunConcurrently() && !p->checkNumericalDerivatives()) {
+      for(const auto & d : p->getDependencies()) if(std::find(batch.begin(),batch.end(),d)!=batch.end()) {
+          calculateBatch(batch);
+          break;
+        }
+      batch.push_back(p);
+      iaction++;
+      continue;
+    }
+    calculateBatch(batch);
     try {
       if(p->isActive()) {
-// Stopwatch is stopped when sw goes out of scope.
-// We explicitly declare a Stopwatch::Handler here to allow for conditional initialization.
-        Stopwatch::Handler sw;
-        if(detailedTimers) {
-          std::string actionNumberLabel;
-          Tools::convert(iaction,actionNumberLabel);
-          const unsigned m=actionSet.size();
-          unsigned k=0; unsigned n=1; while(n<m) { n*=10; k++; }
-          const int pad=k-actionNumberLabel.length();
-          for(int i=0; i<pad; i++) actionNumberLabel=" "+actionNumberLabel;
-          sw=stopwatch.startStop("4A "+actionNumberLabel+" "+p->getLabel());
-        }
-        ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
-        ActionAtomistic*aa=dynamic_cast<ActionAtomistic*>(p);
-        {
-          if(av) av->clearInputForces();
-          if(av) av->clearDerivatives();
-        }
-        {
-          if(aa) aa->clearOutputForces();
-          if(aa) if(aa->isActive()) aa->retrieveAtoms();
-        }
-        if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
-        else p->calculate();
+        calculateAction(p,iaction);
         // This retrieves components called bias
+        ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
         if(av) {
           bias+=av->getOutputQuantity("bias");
           work+=av->getOutputQuantity("work");
-          av->setGradientsIfNeeded();
         }
-        ActionWithVirtualAtom*avv=dynamic_cast<ActionWithVirtualAtom*>(p);
-        if(avv)avv->setGradientsIfNeeded();
       }
     } catch(...) {
       plumed_error_nested() << "An error happened while calculating " << p->getLabel();
     }
     iaction++;
   }
+  calculateBatch(batch);
+}
+
+void PlumedMain::calculateAction(Action* p,int iaction) {
+// Stopwatch is stopped when sw goes out of scope.
+// We explicitly declare a Stopwatch::Handler here to allow for conditional initialization.
+  Stopwatch::Handler sw;
+  if(detailedTimers) {
+    std::string actionNumberLabel;
+    Tools::convert(iaction,actionNumberLabel);
+    const unsigned m=actionSet.size();
+    unsigned k=0; unsigned n=1; while(n<m) { n*=10; k++; }
+    const int pad=k-actionNumberLabel.length();
+    for(int i=0; i<pad; i++) actionNumberLabel=" "+actionNumberLabel;
+    sw=stopwatch.startStop("4A "+actionNumberLabel+" "+p->getLabel());
+  }
+  ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
+  ActionAtomistic*aa=dynamic_cast<ActionAtomistic*>(p);
+  {
+    if(av) av->clearInputForces();
+    if(av) av->clearDerivatives();
+  }
+  {
+    if(aa) aa->clearOutputForces();
+    if(aa) if(aa->isActive()) aa->retrieveAtoms();
+  }
+  if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
+  else p->calculate();
+  if(av) av->setGradientsIfNeeded();
+  ActionWithVirtualAtom*avv=dynamic_cast<ActionWithVirtualAtom*>(p);
+  if(avv)avv->setGradientsIfNeeded();
+}
+
+bool PlumedMain::useConcurrentActions() const {
+// timers are not thread safe, and actions running concurrently should not communicate
+  return concurrentActions && !detailedTimers && OpenMP::getNumThreads()>1 && comm.Get_size()==1;
+}
+
+void PlumedMain::calculateBatch(std::vector<Action*>& batch) {
+  if(batch.empty()) return;
+  std::vector<std::exception_ptr> errors(batch.size());
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt>batch.size()) nt=batch.size();
+  #pragma omp parallel for num_threads(nt) schedule(dynamic)
+  for(unsigned i=0; i<batch.size(); i++) {
+    try {
+      calculateAction(batch[i],-1);
+    } catch(...) {
+      errors[i]=std::current_exception();
+    }
+  }
+// bias and work are accumulated in the same order used in the serial loop
+  for(unsigned i=0; i<batch.size(); i++) {
+    try {
+      if(errors[i]) std::rethrow_exception(errors[i]);
+    } catch(...) {
+      plumed_error_nested() << "An error happened while calculating " << batch[i]->getLabel();
+    }
+    ActionWithValue*av=dynamic_cast<ActionWithValue*>(batch[i]);
+    if(av) {
+      bias+=av->getOutputQuantity("bias");
+      work+=av->getOutputQuantity("work");
+    }
+  }
+  batch.clear();
+}
+
+void PlumedMain::applyBatch(std::vector<Action*>& batch) {
+  if(batch.empty()) return;
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt>batch.size()) nt=batch.size();
+  std::vector<std::exception_ptr> errors(batch.size());
+  #pragma omp parallel for num_threads(nt) schedule(dynamic)
+  for(unsigned i=0; i<batch.size(); i++) {
+    try {
+      batch[i]->apply();
+    } catch(...) {
+      errors[i]=std::current_exception();
+    }
+  }
+// forces on atoms are accumulated serially, in the same order used in the serial loop
+  for(unsigned i=0; i<batch.size(); i++) {
+    try {
+      if(errors[i]) std::rethrow_exception(errors[i]);
+    } catch(...) {
+      plumed_error_nested() << "An error happened while applying forces of " << batch[i]->getLabel();
+    }
+    ActionAtomistic*a=dynamic_cast<ActionAtomistic*>(batch[i]);
+    if(a) a->applyForces();
+  }
+  batch.clear();
 }
 
 void PlumedMain::justApply() {
@@ -977,9 +1066,25 @@ void PlumedMain::backwardPropagate() {
   int iaction=0;
 // Stopwatch is stopped when sw goes out of scope
   auto sw=stopwatch.startStop("5 Applying (backward loop)");
+  const bool concurrent=useConcurrentActions();
+// consecutive independent actions that can run concurrently
+  std::vector<Action*> batch;
 // apply them in reverse order
   for(auto pp=actionSet.rbegin(); pp!=actionSet.rend(); ++pp) {
     const auto & p(pp->get());
+    if(concurrent && p->isActive() && p->canRunConcurrently()) {
+// actions in the batch that depend on this one should have been applied already
+      bool dependent=false;
+      for(const auto & b : batch) {
+        const auto & deps(b->getDependencies());
+        if(std::find(deps.begin(),deps.end(),p)!=deps.end()) dependent=true;
+      }
+      if(dependent) applyBatch(batch);
+      batch.push_back(p);
+      iaction++;
+      continue;
+    }
+    applyBatch(batch);
     if(p->isActive()) {
 
 // Stopwatch is stopped when sw goes out of scope.
@@ -1003,6 +1108,7 @@ void PlumedMain::backwardPropagate() {
     }
     iaction++;
   }
+  applyBatch(batch);
 
 // Stopwatch is stopped when sw goes out of scope.
 // We explicitly declare a Stopwatch::Handler here to allow for conditional initialization.
@@ -1035,10 +1141,11 @@ void PlumedMain::update() {
 // flush by default every 10000 steps
 // hopefully will not affect performance
 // also if receive checkpointing signal
+// actions are flushed first, so that fflush() also waits for the data they submit to the async writer
   if(step%10000==0||doCheckPoint) {
-    fflush();
-    log.flush();
     for(const auto & p : actionSet) p->fflush();
+    log.flush();
+    fflush();
   }
 }
 
@@ -1107,6 +1214,7 @@ void PlumedMain::fflush() {
   for(const auto  & p : files) {
     p->flush();
   }
+  if(asyncWriter) asyncWriter->wait();
 }
 
 void PlumedMain::insertFile(FileBase&f) {
@@ -53,6 +53,7 @@ namespace PLMD {
 
 
 
+class Action;
 class ActionAtomistic;
 class ActionPilot;
 class Log;
@@ -64,6 +65,7 @@ class Stopwatch;
 class Citations;
 class ExchangePatterns;
 class FileBase;
+class AsyncWriter;
 class DataFetchingObject;
 class TypesafePtr;
 class IFile;
@@ -83,6 +85,9 @@ class PlumedMain:
 /// structure. Indeed, this should be destroyed *after* all the actions allocated
 /// in this PlumedMain object have been destroyed.
   std::set<FileBase*> files;
+/// Writer used to write files in background, enabled with PLUMED_ASYNC_OUTPUT=yes.
+/// It should be destroyed after the actions, which complete their writes when destroyed.
+  std::unique_ptr<AsyncWriter> asyncWriter;
 /// Forward declaration.
   ForwardDecl<Communicator> comm_fwd;
 public:
@@ -195,6 +200,15 @@ private:
 /// Flag for checkpointig
   bool doCheckPoint;
 
+/// Check if independent actions should be calculated concurrently
+  bool useConcurrentActions() const;
+/// Calculate a single action in the forward loop (bias and work are not accumulated here)
+  void calculateAction(Action* p,int iaction);
+/// Calculate concurrently a batch of independent actions, then empty it
+  void calculateBatch(std::vector<Action*>& batch);
+/// Apply concurrently a batch of independent actions, then empty it
+  void applyBatch(std::vector<Action*>& batch);
+
 private:
 /// Forward declaration.
   ForwardDecl<TypesafePtr> stopFlag_fwd;
@@ -214,6 +228,9 @@ public:
 /// Flag to switch on detailed timers
   bool detailedTimers;
 
+/// Flag to calculate concurrently independent actions that allow it
+  bool concurrentActions;
+
 /// GpuDevice Identifier
   int gpuDeviceId;
 
@@ -363,6 +380,8 @@ public:
   const ActionSet & getActionSet()const;
 /// Referenge to the log stream
   Log & getLog();
+/// Reference to the main stopwatch
+  Stopwatch & getStopwatch();
 /// Return the number of the step
   long long int getStep()const {return step;}
 /// Stop the run
@@ -387,8 +406,11 @@ public:
   void insertFile(FileBase&);
 /// Erase a file
   void eraseFile(FileBase&);
-/// Flush all files
+/// Flush all files.
+/// When files are written in background, it waits until all the data have been written
   void fflush();
+/// Get the writer used to write files in background. NULL if files are written synchronously
+  AsyncWriter* getAsyncWriter() {return asyncWriter.get();}
 /// Check if restarting
   bool getRestart()const;
 /// Set restart flag
@@ -455,6 +477,11 @@ Atoms& PlumedMain::getAtoms() {
   return atoms;
 }
 
+inline
+Stopwatch& PlumedMain::getStopwatch() {
+  return stopwatch;
+}
+
 inline
 const std::string & PlumedMain::getSuffix()const {
   return suffix;
@@ -36,6 +36,7 @@ Value::Value():
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparseDeriv(false),
   hasDeriv(true),
   periodicity(unset),
   min(0.0),
@@ -51,6 +52,7 @@ Value::Value(const std::string& name):
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparseDeriv(false),
   name(name),
   hasDeriv(true),
   periodicity(unset),
@@ -67,6 +69,7 @@ Value::Value(ActionWithValue* av, const std::string& name, const bool withderiv)
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparseDeriv(false),
   name(name),
   hasDeriv(withderiv),
   periodicity(unset),
@@ -96,11 +99,29 @@ bool Value::isPeriodic()const {
 bool Value::applyForce(std::vector<double>& forces ) const {
   if( !hasForce ) return false;
   plumed_dbg_massert( derivatives.size()==forces.size()," forces array has wrong size" );
+  if(sparseDeriv) {
+    std::fill(forces.begin(),forces.end(),0.0);
+    for(const auto & i : activeDeriv) forces[i]=inputForce*derivatives[i];
+    return true;
+  }
   const unsigned N=derivatives.size();
   for(unsigned i=0; i<N; ++i) forces[i]=inputForce*derivatives[i];
   return true;
 }
 
+void Value::setSparseDerivatives(bool s) {
+  if(s==sparseDeriv) return;
+  sparseDeriv=s;
+  activeDeriv.clear();
+  if(sparseDeriv) {
+// derivatives that are already non zero must be tracked
+    isActiveDeriv.assign(derivatives.size(),0);
+    for(unsigned i=0; i<derivatives.size(); ++i) if(derivatives[i]!=0.0) activateDerivative(i);
+  } else {
+    isActiveDeriv.clear();
+  }
+}
+
 void Value::setNotPeriodic() {
   min=0; max=0; periodicity=notperiodic;
 }
@@ -179,7 +200,11 @@ void copy( const Value& val1, Value& val2 ) {
   unsigned nder=val1.getNumberOfDerivatives();
   if( nder!=val2.getNumberOfDerivatives() ) { val2.resizeDerivatives( nder ); }
   val2.clearDerivatives();
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2.addDerivative( i, val1.getDerivative(i) );
+  if(val1.hasSparseDerivatives()) {
+    for(const auto & i : val1.activeDeriv) val2.addDerivative( i, val1.getDerivative(i) );
+  } else {
+    for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2.addDerivative( i, val1.getDerivative(i) );
+  }
   val2.set( val1.get() );
 }
 
@@ -187,13 +212,21 @@ void copy( const Value& val1, Value* val2 ) {
   unsigned nder=val1.getNumberOfDerivatives();
   if( nder!=val2->getNumberOfDerivatives() ) { val2->resizeDerivatives( nder ); }
   val2->clearDerivatives();
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2->addDerivative( i, val1.getDerivative(i) );
+  if(val1.hasSparseDerivatives()) {
+    for(const auto & i : val1.activeDeriv) val2->addDerivative( i, val1.getDerivative(i) );
+  } else {
+    for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2->addDerivative( i, val1.getDerivative(i) );
+  }
   val2->set( val1.get() );
 }
 
 void add( const Value& val1, Value* val2 ) {
   plumed_assert( val1.getNumberOfDerivatives()==val2->getNumberOfDerivatives() );
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2->addDerivative( i, val1.getDerivative(i) );
+  if(val1.hasSparseDerivatives()) {
+    for(const auto & i : val1.activeDeriv) val2->addDerivative( i, val1.getDerivative(i) );
+  } else {
+    for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2->addDerivative( i, val1.getDerivative(i) );
+  }
   val2->set( val1.get() + val2->get() );
 }
 
@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <algorithm>
 #include "tools/Exception.h"
 #include "tools/Tools.h"
 #include "tools/AtomNumber.h"
@@ -68,6 +69,14 @@ private:
   bool hasForce;
 /// The derivatives of the quantity stored in value
   std::vector<double> derivatives;
+/// Are we keeping track of which derivatives are non zero
+  bool sparseDeriv;
+/// The indices of the derivatives that have been set since the last clearDerivatives()
+  std::vector<unsigned> activeDeriv;
+/// Flags telling if each derivative is in activeDeriv
+  std::vector<unsigned char> isActiveDeriv;
+/// Add a derivative to the list of active derivatives
+  void activateDerivative(unsigned i);
   std::map<AtomNumber,Vector> gradients;
 /// The name of this quantiy
   std::string name;
@@ -119,6 +128,15 @@ public:
   void resizeDerivatives(int n);
 /// Set all the derivatives to zero
   void clearDerivatives();
+/// Keep track of the derivatives that are set, so that clearing them and applying forces
+/// only loops over them. Useful for values that only depend on a few atoms among many
+  void setSparseDerivatives(bool s);
+/// Check if we are keeping track of the derivatives that are set
+  bool hasSparseDerivatives() const;
+/// Get the number of derivatives that have been set since they were last cleared (only with sparse derivatives)
+  unsigned getNumberOfActiveDerivatives() const;
+/// Get the index of the i-th derivative that has been set (only with sparse derivatives)
+  unsigned getActiveDerivativeIndex(unsigned i) const;
 /// Add some derivative to the ith component of the derivatives array
   void addDerivative(unsigned i,double d);
 /// Set the value of the ith component of the derivatives array
@@ -238,24 +256,61 @@ bool Value::hasDerivatives() const {
 
 inline
 void Value::resizeDerivatives(int n) {
-  if(hasDeriv) derivatives.resize(n);
+  if(!hasDeriv) return;
+  derivatives.resize(n);
+  if(sparseDeriv) {
+// derivatives are kept as in dense mode, those beyond the new size are not tracked anymore
+    activeDeriv.erase(std::remove_if(activeDeriv.begin(),activeDeriv.end(),[n](unsigned i) {return i>=unsigned(n);}),activeDeriv.end());
+    isActiveDeriv.resize(n,0);
+  }
+}
+
+inline
+void Value::activateDerivative(unsigned i) {
+  if(!isActiveDeriv[i]) {
+    isActiveDeriv[i]=1;
+    activeDeriv.push_back(i);
+  }
 }
 
 inline
 void Value::addDerivative(unsigned i,double d) {
   plumed_dbg_massert(i<derivatives.size(),"derivative is out of bounds");
+  if(sparseDeriv) activateDerivative(i);
   derivatives[i]+=d;
 }
 
 inline
 void Value::setDerivative(unsigned i, double d) {
   plumed_dbg_massert(i<derivatives.size(),"derivative is out of bounds");
+  if(sparseDeriv) activateDerivative(i);
   derivatives[i]=d;
 }
 
 inline
 void Value::chainRule(double df) {
-  for(unsigned i=0; i<derivatives.size(); ++i) derivatives[i]*=df;
+  if(sparseDeriv) {
+    for(unsigned i=0; i<activeDeriv.size(); ++i) derivatives[activeDeriv[i]]*=df;
+  } else {
+    for(unsigned i=0; i<derivatives.size(); ++i) derivatives[i]*=df;
+  }
+}
+
+inline
+bool Value::hasSparseDerivatives() const {
+  return sparseDeriv;
+}
+
+inline
+unsigned Value::getNumberOfActiveDerivatives() const {
+  plumed_dbg_massert(sparseDeriv,"active derivatives are only available with sparse derivatives");
+  return activeDeriv.size();
+}
+
+inline
+unsigned Value::getActiveDerivativeIndex(unsigned i) const {
+  plumed_dbg_massert(i<activeDeriv.size(),"active derivative is out of bounds");
+  return activeDeriv[i];
 }
 
 inline
@@ -267,7 +322,15 @@ void Value::clearInputForce() {
 inline
 void Value::clearDerivatives() {
   value_set=false;
-  std::fill(derivatives.begin(), derivatives.end(), 0);
+  if(sparseDeriv) {
+    for(const auto & i : activeDeriv) {
+      derivatives[i]=0.0;
+      isActiveDeriv[i]=0;
+    }
+    activeDeriv.clear();
+  } else {
+    std::fill(derivatives.begin(), derivatives.end(), 0);
+  }
 }
 
 inline
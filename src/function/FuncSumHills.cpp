@@ -92,9 +92,19 @@ bool FilesHandler::readBunch(BiasRepresentation *br, int stride = -1) {
       ff->open(filenames[beingread]); isopen=true;
     }
     int n=0;
+    // maximum number of histogram points read at once
+    const std::size_t blocksize=4096;
     while(true) {
       bool fileisover=true;
       while(scanOneHill(br,ff)) {
+        // histogram points that follow, up to the next header, are read in bulk
+        if(br->hasSigmaInInput()) {
+          while(true) {
+            n=br->getNumberOfKernels();
+            if(stride>0 && n%stride==0) break;
+            if(br->pushKernels(ff,stride>0?stride-n%stride:blocksize)==0) break;
+          }
+        }
         // here do the dump if needed
         n=br->getNumberOfKernels();
         if(stride>0 && n%stride==0 && n!=0  ) {
@@ -23,6 +23,9 @@
 #include "core/ActionPilot.h"
 #include "core/ActionSet.h"
 #include "core/PlumedMain.h"
+#include "tools/Stopwatch.h"
+
+#include <sstream>
 
 namespace PLMD {
 namespace generic {
@@ -42,22 +45,49 @@ DEBUG DETAILED_TIMERS
 DEBUG logRequestedAtoms STRIDE=2
 \endplumedfile
 
+With CONCURRENT_ACTIONS, consecutive independent actions that allow it (e.g. \ref DISTANCE, \ref ANGLE and \ref TORSION)
+are calculated concurrently using the OpenMP threads. This is only done when running a single MPI process
+per replica and when DETAILED_TIMERS is not used.
+\plumedfile
+DEBUG CONCURRENT_ACTIONS
+d1: DISTANCE ATOMS=1,2
+d2: DISTANCE ATOMS=3,4
+t1: TORSION ATOMS=1,2,3,4
+\endplumedfile
+
+With TIMINGS_FILE, detailed timers are switched on and statistics about them are written
+every STRIDE steps on a file in a machine readable format (see TIMINGS_FORMAT).
+For each timer, including the per-action ones, the file reports the number of cycles
+and the total, average, minimum and maximum time spent since the beginning of the simulation.
+It also reports the median, the 90th and the 99th percentile and the maximum of the times
+of the cycles completed since the previous output. Times are in seconds.
+\plumedfile
+DEBUG TIMINGS_FILE=timings.json TIMINGS_FORMAT=json STRIDE=100
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 class Debug:
   public ActionPilot
 {
   OFile ofile;
+  OFile timingsOfile;
+  std::string timingsFormat;
+  bool timingsHeader;
   bool logActivity;
   bool logRequestedAtoms;
   bool novirial;
   bool detailedTimers;
+  bool concurrentActions;
 public:
   explicit Debug(const ActionOptions&ao);
+  ~Debug();
 /// Register all the relevant keywords for the action
   static void registerKeywords( Keywords& keys );
   void calculate() override {}
   void apply() override;
+/// Write timing statistics on timingsOfile
+  void writeTimings();
 };
 
 PLUMED_REGISTER_ACTION(Debug,"DEBUG")
@@ -70,15 +100,21 @@ void Debug::registerKeywords( Keywords& keys ) {
   keys.addFlag("logRequestedAtoms",false,"write in the log which atoms have been requested at a given time");
   keys.addFlag("NOVIRIAL",false,"switch off the virial contribution for the entirety of the simulation");
   keys.addFlag("DETAILED_TIMERS",false,"switch on detailed timers");
+  keys.addFlag("CONCURRENT_ACTIONS",false,"calculate concurrently independent actions that allow it");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
+  keys.add("optional","TIMINGS_FILE","switch on detailed timers and periodically write their statistics on this file");
+  keys.add("compulsory","TIMINGS_FORMAT","json","the format of TIMINGS_FILE, either json (one object per line) or csv");
 }
 
 Debug::Debug(const ActionOptions&ao):
   Action(ao),
   ActionPilot(ao),
+  timingsHeader(true),
   logActivity(false),
   logRequestedAtoms(false),
-  novirial(false) {
+  novirial(false),
+  detailedTimers(false),
+  concurrentActions(false) {
   parseFlag("logActivity",logActivity);
   if(logActivity) log.printf("  logging activity\n");
   parseFlag("logRequestedAtoms",logRequestedAtoms);
@@ -91,6 +127,11 @@ Debug::Debug(const ActionOptions&ao):
     log.printf("  Detailed timing on\n");
     plumed.detailedTimers=true;
   }
+  parseFlag("CONCURRENT_ACTIONS",concurrentActions);
+  if(concurrentActions) {
+    log.printf("  Calculating independent actions concurrently\n");
+    plumed.concurrentActions=true;
+  }
   ofile.link(*this);
   std::string file;
   parse("FILE",file);
@@ -101,6 +142,17 @@ Debug::Debug(const ActionOptions&ao):
     log.printf("  on plumed log file\n");
     ofile.link(log);
   }
+  std::string timingsFile;
+  parse("TIMINGS_FILE",timingsFile);
+  parse("TIMINGS_FORMAT",timingsFormat);
+  if(timingsFile.length()>0) {
+    if(timingsFormat!="json" && timingsFormat!="csv") error("TIMINGS_FORMAT should be either json or csv");
+    timingsOfile.link(*this);
+    timingsOfile.open(timingsFile);
+    log.printf("  writing timing statistics in %s format on file %s\n",timingsFormat.c_str(),timingsFile.c_str());
+    plumed.detailedTimers=true;
+    plumed.getStopwatch().setKeepLaps(true);
+  }
   checkRead();
 }
 
@@ -132,7 +184,21 @@ void Debug::apply() {
     ofile.printf("\n");
     plumed.cmd("clearFullList");
   }
+  if(timingsOfile.isOpen()) writeTimings();
+
+}
+
+Debug::~Debug() {
+// write the cycles completed after the last output
+  if(timingsOfile.isOpen()) writeTimings();
+}
 
+void Debug::writeTimings() {
+  std::ostringstream oss;
+  plumed.getStopwatch().printStatistics(oss,timingsFormat,getStep(),timingsHeader);
+  timingsHeader=false;
+  timingsOfile<<oss.str();
+  timingsOfile.flush();
 }
 
 }
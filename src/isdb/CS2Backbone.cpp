@@ -34,6 +34,8 @@
 #include <fstream>
 #include <iterator>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #include "MetainferenceBase.h"
 #include "core/ActionRegister.h"
@@ -472,12 +474,16 @@ class CS2Backbone : public MetainferenceBase {
   unsigned         max_cs_atoms;
   unsigned         box_nupdate;
   unsigned         box_count;
+  double           box_skin;
+  bool             box_rebuild;
+  std::vector<Vector> box_reference;
   bool             camshift;
   bool             pbc;
   bool             serial;
 
   void init_cs(const std::string &file, const std::string &k, const PDB &pdb);
   void update_neighb();
+  bool skin_exceeded() const;
   void compute_ring_parameters();
   void init_types(const PDB &pdb);
   void init_rings(const PDB &pdb);
@@ -505,7 +511,8 @@ void CS2Backbone::registerKeywords( Keywords& keys ) {
   keys.add("atoms","ATOMS","The atoms to be included in the calculation, e.g. the whole protein.");
   keys.add("compulsory","DATADIR","data/","The folder with the experimental chemical shifts.");
   keys.add("compulsory","TEMPLATE","template.pdb","A PDB file of the protein system.");
-  keys.add("compulsory","NEIGH_FREQ","20","Period in step for neighbor list update.");
+  keys.add("optional","NEIGH_FREQ","Period in step for neighbor list update, 20 if not given.");
+  keys.add("optional","NEIGH_SKIN","If present, the neighbor list includes the atoms within the non-bonded cutoff plus this skin, and it is updated only when an atom has moved by more than half of the skin instead of every NEIGH_FREQ steps. Cannot be used together with NEIGH_FREQ.");
   keys.addFlag("CAMSHIFT",false,"Set to TRUE if you to calculate a single CamShift score.");
   keys.addFlag("NOEXP",false,"Set to TRUE if you don't want to have fixed components with the experimental values.");
   keys.addOutputComponent("ha","default","the calculated Ha hydrogen chemical shifts");
@@ -525,6 +532,8 @@ void CS2Backbone::registerKeywords( Keywords& keys ) {
 CS2Backbone::CS2Backbone(const ActionOptions&ao):
   PLUMED_METAINF_INIT(ao),
   max_cs_atoms(0),
+  box_skin(0.),
+  box_rebuild(true),
   camshift(false),
   pbc(true),
   serial(false)
@@ -552,7 +561,16 @@ CS2Backbone::CS2Backbone(const ActionOptions&ao):
 
   box_count=0;
   box_nupdate=20;
-  parse("NEIGH_FREQ", box_nupdate);
+  int neigh_freq=-1;
+  parse("NEIGH_FREQ", neigh_freq);
+  parse("NEIGH_SKIN", box_skin);
+  if(box_skin<0.) error("NEIGH_SKIN should be positive");
+  if(neigh_freq>=0) {
+    if(box_skin>0.) error("NEIGH_FREQ is ignored when NEIGH_SKIN is used, remove it");
+    box_nupdate=neigh_freq;
+  }
+  if(box_skin>0.) log.printf("  neighbor list cutoff %f including a skin %f, updated when an atom moves by more than half the skin\n",cutOffDist+box_skin,box_skin);
+  else log.printf("  neighbor list cutoff %f, updated every %u steps\n",cutOffNB,box_nupdate);
 
   std::string stringadb  = stringa_data + std::string("/camshift.db");
   std::string stringapdb = stringa_data + std::string("/") + stringa_template;
@@ -955,8 +973,13 @@ void CS2Backbone::init_rings(const PDB &pdb)
 void CS2Backbone::calculate()
 {
   if(pbc) makeWhole();
-  if(getExchangeStep()) box_count=0;
-  if(box_count==0) update_neighb();
+  if(getExchangeStep()) {
+    box_count=0;
+    box_rebuild=true;
+  }
+  if(box_skin>0.) {
+    if(box_rebuild || skin_exceeded()) update_neighb();
+  } else if(box_count==0) update_neighb();
   compute_ring_parameters();
 
   std::vector<double> camshift_sigma2(6);
@@ -1283,6 +1306,8 @@ void CS2Backbone::calculate()
       }
       comm.Sum(&all_shifts[0], chemicalshifts.size());
     }
+    // each chemical shift has its own component, so they can be set in parallel
+    #pragma omp parallel for num_threads(nt) schedule(dynamic)
     for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
       Value *comp = chemicalshifts[cs].comp;
       comp->set(all_shifts[cs]);
@@ -1305,25 +1330,33 @@ void CS2Backbone::calculate()
   /* Metainference */
   if(getDoScore()) {
     score = getScore();
-    for(unsigned cs=rank; cs<chemicalshifts.size(); cs+=stride) {
-      const unsigned kdx=cs*max_cs_atoms;
-      const double fact = getMetaDer(cs);
-      for(unsigned i=0; i<chemicalshifts[cs].totcsatoms; i++) {
-        aa_derivs[cs_atoms[kdx+i]] += cs_derivs[kdx+i]*fact;
-      }
-    }
   }
 
-  /* camshift */
-  if(camshift) {
+  /* sum the derivatives of the chemical shifts, each thread on its own copy */
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<Vector> omp_derivs(aa_derivs.size());
+    double omp_score = 0.;
+    #pragma omp for schedule(dynamic) nowait
     for(unsigned cs=rank; cs<chemicalshifts.size(); cs+=stride) {
       const unsigned kdx=cs*max_cs_atoms;
-      score += (all_shifts[cs] - chemicalshifts[cs].exp_cs)*(all_shifts[cs] - chemicalshifts[cs].exp_cs)/camshift_sigma2[chemicalshifts[cs].atm_kind];
-      double fact = 2.0*(all_shifts[cs] - chemicalshifts[cs].exp_cs)/camshift_sigma2[chemicalshifts[cs].atm_kind];
+      double fact;
+      if(getDoScore()) fact = getMetaDer(cs);
+      else {
+        /* camshift */
+        const double diff = all_shifts[cs] - chemicalshifts[cs].exp_cs;
+        omp_score += diff*diff/camshift_sigma2[chemicalshifts[cs].atm_kind];
+        fact = 2.0*diff/camshift_sigma2[chemicalshifts[cs].atm_kind];
+      }
       for(unsigned i=0; i<chemicalshifts[cs].totcsatoms; i++) {
-        aa_derivs[cs_atoms[kdx+i]] += cs_derivs[kdx+i]*fact;
+        omp_derivs[cs_atoms[kdx+i]] += cs_derivs[kdx+i]*fact;
       }
     }
+    #pragma omp critical
+    {
+      for(unsigned i=0; i<aa_derivs.size(); i++) aa_derivs[i] += omp_derivs[i];
+      score += omp_score;
+    }
   }
 
   if(!serial) {
@@ -1332,8 +1365,15 @@ void CS2Backbone::calculate()
   }
 
   Tensor virial;
-  for(unsigned i=rank; i<getNumberOfAtoms(); i+=stride) {
-    virial += Tensor(getPosition(i), aa_derivs[i]);
+  #pragma omp parallel num_threads(nt)
+  {
+    Tensor omp_virial;
+    #pragma omp for nowait
+    for(unsigned i=rank; i<getNumberOfAtoms(); i+=stride) {
+      omp_virial += Tensor(getPosition(i), aa_derivs[i]);
+    }
+    #pragma omp critical
+    virial += omp_virial;
   }
 
   if(!serial) {
@@ -1356,27 +1396,97 @@ void CS2Backbone::calculate()
 }
 
 void CS2Backbone::update_neighb() {
+  const unsigned natoms = getNumberOfAtoms();
+  const double cutoff = (box_skin>0.) ? cutOffDist+box_skin : cutOffNB;
+  const double cutoff2 = cutoff*cutoff;
+
+  // atoms are sorted in cells whose size is at least the cutoff, so that
+  // only the neighboring cells of each nucleus must be searched
+  Vector lower = getPosition(0);
+  Vector upper = getPosition(0);
+  for(unsigned i=1; i<natoms; i++) {
+    const Vector & pos = getPosition(i);
+    for(unsigned k=0; k<3; k++) {
+      lower[k] = std::min(lower[k], pos[k]);
+      upper[k] = std::max(upper[k], pos[k]);
+    }
+  }
+  // cells are enlarged if the atoms are too sparse
+  double cell_size = cutoff;
+  unsigned ncell[3];
+  while(true) {
+    double ncells = 1.;
+    for(unsigned k=0; k<3; k++) {
+      ncell[k] = std::max(1, static_cast<int>(std::floor((upper[k]-lower[k])/cell_size)));
+      ncells *= ncell[k];
+    }
+    if(ncells <= 8.*natoms+27.) break;
+    cell_size *= 1.25;
+  }
+  const unsigned ncells = ncell[0]*ncell[1]*ncell[2];
+  std::vector<unsigned> cell_of(natoms);
+  std::vector<unsigned> cell_start(ncells+1,0);
+  for(unsigned i=0; i<natoms; i++) {
+    unsigned c[3];
+    for(unsigned k=0; k<3; k++) {
+      const double width = upper[k]-lower[k];
+      const double x = (width>0.) ? (getPosition(i)[k]-lower[k])/width*ncell[k] : 0.;
+      c[k] = std::min(ncell[k]-1, static_cast<unsigned>(std::max(0., x)));
+    }
+    cell_of[i] = (c[0]*ncell[1]+c[1])*ncell[2]+c[2];
+    cell_start[cell_of[i]+1]++;
+  }
+  for(unsigned c=0; c<ncells; c++) cell_start[c+1] += cell_start[c];
+  std::vector<unsigned> cell_atoms(natoms);
+  {
+    std::vector<unsigned> fill(cell_start.begin(), cell_start.end()-1);
+    for(unsigned i=0; i<natoms; i++) cell_atoms[fill[cell_of[i]]++] = i;
+  }
+
   // cycle over chemical shifts
   unsigned nt=OpenMP::getNumThreads();
-  #pragma omp parallel for num_threads(nt)
+  #pragma omp parallel for num_threads(nt) schedule(dynamic)
   for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
-    const unsigned boxsize = getNumberOfAtoms();
+    const unsigned ipos = chemicalshifts[cs].ipos;
     chemicalshifts[cs].box_nb.clear();
-    chemicalshifts[cs].box_nb.reserve(150);
-    const unsigned res_curr = res_num[chemicalshifts[cs].ipos];
-    for(unsigned bat=0; bat<boxsize; bat++) {
-      const unsigned res_dist = std::abs(static_cast<int>(res_curr-res_num[bat]));
-      if(res_dist<2) continue;
-      const Vector distance = delta(getPosition(bat),getPosition(chemicalshifts[cs].ipos));
-      const double d2=distance.modulo2();
-      if(d2<cutOffNB2) chemicalshifts[cs].box_nb.push_back(bat);
+    const unsigned res_curr = res_num[ipos];
+    const unsigned c = cell_of[ipos];
+    const int cx = c/(ncell[1]*ncell[2]);
+    const int cy = (c/ncell[2])%ncell[1];
+    const int cz = c%ncell[2];
+    for(int ix=std::max(cx-1,0); ix<=std::min(cx+1,static_cast<int>(ncell[0])-1); ix++) {
+      for(int iy=std::max(cy-1,0); iy<=std::min(cy+1,static_cast<int>(ncell[1])-1); iy++) {
+        for(int iz=std::max(cz-1,0); iz<=std::min(cz+1,static_cast<int>(ncell[2])-1); iz++) {
+          const unsigned n = (ix*ncell[1]+iy)*ncell[2]+iz;
+          for(unsigned j=cell_start[n]; j<cell_start[n+1]; j++) {
+            const unsigned bat = cell_atoms[j];
+            const unsigned res_dist = std::abs(static_cast<int>(res_curr-res_num[bat]));
+            if(res_dist<2) continue;
+            const Vector distance = delta(getPosition(bat),getPosition(ipos));
+            const double d2=distance.modulo2();
+            if(d2<cutoff2) chemicalshifts[cs].box_nb.push_back(bat);
+          }
+        }
+      }
     }
+    // keep the atoms sorted, so that the shifts do not depend on the cells
+    std::sort(chemicalshifts[cs].box_nb.begin(), chemicalshifts[cs].box_nb.end());
     chemicalshifts[cs].totcsatoms = chemicalshifts[cs].csatoms + chemicalshifts[cs].box_nb.size();
   }
   max_cs_atoms=0;
   for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
     if(chemicalshifts[cs].totcsatoms>max_cs_atoms) max_cs_atoms = chemicalshifts[cs].totcsatoms;
   }
+  if(box_skin>0.) box_reference = getPositions();
+  box_rebuild = false;
+}
+
+bool CS2Backbone::skin_exceeded() const {
+  const double maxdisp2 = 0.25*box_skin*box_skin;
+  for(unsigned i=0; i<getNumberOfAtoms(); i++) {
+    if(delta(box_reference[i],getPosition(i)).modulo2()>maxdisp2) return true;
+  }
+  return false;
 }
 
 void CS2Backbone::compute_ring_parameters() {
@@ -29,11 +29,13 @@
 #include "core/ActionSet.h"
 #include "tools/File.h"
 #include "tools/Random.h"
+#include "tools/OpenMP.h"
 
 #include <string>
 #include <map>
 #include <numeric>
 #include <ctime>
+#include <limits>
 
 namespace PLMD {
 namespace isdb {
@@ -78,7 +80,9 @@ parameters are listed in the file GMM_fit.dat. This file contains one line per G
 \endplumedfile
 
 To accelerate the computation of the Bayesian score, one can:
-- use neighbor lists, specified by the keywords NL_CUTOFF and NL_STRIDE;
+- use neighbor lists, specified by the keywords NL_CUTOFF and NL_STRIDE. The neighbor list is built
+  using a grid over the GMM components, so that each atom only visits the components that are close to it;
+- use OpenMP threads, which are used to build the neighbor list and to calculate the overlaps;
 - calculate the restraint every other step (or more).
 
 All the heavy atoms of the system are used to calculate the density map. This list can conveniently be provided
@@ -156,6 +160,14 @@ private:
   bool first_time_;
   bool no_aver_;
   std::vector<unsigned> nl_;
+// spatial index of data GMM components used to build the neighbor list
+// maximum distance of an atom of a given type from a component in the list
+  std::vector<double> nl_rcut_;
+  double   cell_size_;
+  Vector   cell_origin_;
+  unsigned cell_n_[3];
+  std::vector<unsigned> cell_starts_;
+  std::vector<unsigned> cell_ids_;
 // parallel stuff
   unsigned size_;
   unsigned rank_;
@@ -247,6 +259,8 @@ private:
 // calculate exponent of overlap for neighbor list update
   double get_exp_overlap(const Vector &m_m, const Vector &d_m,
                          const VectorGeneric<6> &inv_cov_md);
+// build the spatial index of data GMM components
+  void setup_cell_index();
 // update the neighbor list
   void update_neighbor_list();
 // calculate overlap
@@ -409,6 +423,7 @@ void EMMI::registerKeywords( Keywords& keys ) {
   keys.add("optional","REG_SCALE_MIN","regression minimum scale");
   keys.add("optional","REG_SCALE_MAX","regression maximum scale");
   keys.add("optional","REG_DSCALE","regression maximum scale MC move");
+  keys.add("optional","SEED","seed for the random number generator of the Monte Carlo moves, the replica index is added to it. If not given, the current time is used");
   keys.add("optional","SCALE","scale factor");
   keys.add("optional","ANNEAL", "Length of annealing cycle");
   keys.add("optional","ANNEAL_FACT", "Annealing temperature factor");
@@ -531,6 +546,10 @@ EMMI::EMMI(const ActionOptions&ao):
     if(dscale_<=0.) error("with REGRESSION, REG_DSCALE must be positive");
   }
 
+  // random seed
+  int seed=-1;
+  parse("SEED", seed);
+
   // scale factor
   parse("SCALE", scale_);
 
@@ -699,6 +718,9 @@ EMMI::EMMI(const ActionOptions&ao):
   // calculate auxiliary stuff
   calculate_useful_stuff(reso);
 
+  // spatial index of data GMM components for the neighbor list
+  setup_cell_index();
+
   // prepare data and derivative std::vectors
   ovmd_.resize(ovdd_.size());
   ovmd_ave_.resize(ovdd_.size());
@@ -739,8 +761,9 @@ EMMI::EMMI(const ActionOptions&ao):
 
   // initialize random seed
   unsigned iseed;
-  if(rank_==0) iseed = time(NULL)+replica_;
-  else iseed = 0;
+  if(rank_!=0) iseed = 0;
+  else if(seed>=0) iseed = seed+replica_;
+  else iseed = time(NULL)+replica_;
   comm.Sum(&iseed, 1);
   random_.setSeed(-iseed);
 
@@ -1152,6 +1175,10 @@ void EMMI::calculate_useful_stuff(double reso)
   log.printf("  blur factor : %f\n", blur);
   // now calculate useful stuff
   VectorGeneric<6> cov, sum, inv_sum;
+  // largest eigenvalue of the sum of covariances for each atom type
+  std::vector<double> eig_max(GMM_m_s_.size(), 0.0);
+  Matrix<double> sum_m(3,3), evec(3,3);
+  std::vector<double> eval(3);
   // cycle on all atoms types (4 for the moment)
   for(unsigned i=0; i<GMM_m_s_.size(); ++i) {
     // the Gaussian in density (real) space is the FT of scattering factor
@@ -1182,6 +1209,13 @@ void EMMI::calculate_useful_stuff(double reso)
       pre_fact_.push_back(pre_fact);
       // and the inverse of the sum
       inv_cov_md_.push_back(inv_sum);
+      // the exponent of the overlap is larger than the squared distance
+      // divided by the largest eigenvalue of the sum
+      sum_m(0,0)=sum[0]; sum_m(0,1)=sum_m(1,0)=sum[1]; sum_m(0,2)=sum_m(2,0)=sum[2];
+      sum_m(1,1)=sum[3]; sum_m(1,2)=sum_m(2,1)=sum[4];
+      sum_m(2,2)=sum[5];
+      if(diagMat(sum_m, eval, evec)!=0) error("cannot diagonalize covariance matrix");
+      eig_max[i] = std::max(eig_max[i], eval[2]);
     }
   }
   // tabulate exponential
@@ -1189,6 +1223,54 @@ void EMMI::calculate_useful_stuff(double reso)
   for(unsigned i=0; i<nexp_; ++i) {
     tab_exp_.push_back(std::exp(-static_cast<double>(i) * dexp_));
   }
+  // atoms farther than this from a component are beyond the tabulated exponential
+  nl_rcut_.resize(GMM_m_s_.size());
+  for(unsigned i=0; i<GMM_m_s_.size(); ++i) {
+    nl_rcut_[i] = std::sqrt( 2.0 * dexp_ * static_cast<double>(nexp_) * eig_max[i] );
+  }
+}
+
+void EMMI::setup_cell_index()
+{
+  unsigned GMM_d_size = GMM_d_m_.size();
+  // bounding box of the data GMM components
+  Vector cmax = GMM_d_m_[0];
+  cell_origin_ = GMM_d_m_[0];
+  for(unsigned i=1; i<GMM_d_size; ++i) {
+    for(unsigned k=0; k<3; ++k) {
+      cell_origin_[k] = std::min(cell_origin_[k], GMM_d_m_[i][k]);
+      cmax[k] = std::max(cmax[k], GMM_d_m_[i][k]);
+    }
+  }
+  // cells are as large as the largest cutoff, so that each atom visits at most 27 cells,
+  // but not so small that there are many more cells than components
+  cell_size_ = *std::max_element(nl_rcut_.begin(), nl_rcut_.end());
+  unsigned ncells;
+  while(true) {
+    ncells = 1;
+    for(unsigned k=0; k<3; ++k) {
+      cell_n_[k] = static_cast<unsigned>(std::floor((cmax[k]-cell_origin_[k])/cell_size_)) + 1;
+      ncells *= cell_n_[k];
+    }
+    if(ncells <= 8*GMM_d_size) break;
+    cell_size_ *= 1.25;
+  }
+  // sort components by cell
+  std::vector<unsigned> cell_of(GMM_d_size);
+  cell_starts_.assign(ncells+1, 0);
+  for(unsigned i=0; i<GMM_d_size; ++i) {
+    unsigned c[3];
+    for(unsigned k=0; k<3; ++k) {
+      c[k] = std::min(cell_n_[k]-1, static_cast<unsigned>(std::floor((GMM_d_m_[i][k]-cell_origin_[k])/cell_size_)));
+    }
+    cell_of[i] = c[0] + cell_n_[0] * ( c[1] + cell_n_[1] * c[2] );
+    cell_starts_[cell_of[i]+1]++;
+  }
+  for(unsigned i=0; i<ncells; ++i) cell_starts_[i+1] += cell_starts_[i];
+  cell_ids_.resize(GMM_d_size);
+  std::vector<unsigned> pos(cell_starts_.begin(), cell_starts_.end()-1);
+  for(unsigned i=0; i<GMM_d_size; ++i) cell_ids_[pos[cell_of[i]]++] = i;
+  log.printf("  neighbor list built on a grid of %u x %u x %u cells of size %lf\n", cell_n_[0], cell_n_[1], cell_n_[2], cell_size_);
 }
 
 // get prefactors
@@ -1285,51 +1367,138 @@ void EMMI::update_neighbor_list()
   // clear old neighbor list
   nl_.clear();
 
-  // cycle on GMM components - in parallel
+  // with pbc, the atoms are brought close to the center of the grid and
+  // all the periodic images that can be close to a component are visited
+  Vector center = cell_origin_;
+  for(unsigned k=0; k<3; ++k) center[k] += 0.5 * cell_size_ * static_cast<double>(cell_n_[k]);
+  double rmax = *std::max_element(nl_rcut_.begin(), nl_rcut_.end());
+  std::vector<Vector> shifts(1, Vector(0,0,0));
+  if(pbc_) {
+    const Tensor box = getBox();
+    const Tensor reciprocal(transpose(getPbc().getInvBox()));
+    double reach = 0.5 * cell_size_ * std::sqrt(static_cast<double>(cell_n_[0]*cell_n_[0]+cell_n_[1]*cell_n_[1]+cell_n_[2]*cell_n_[2]));
+    reach += rmax + 0.5 * ( box.getRow(0).modulo() + box.getRow(1).modulo() + box.getRow(2).modulo() );
+    int nimg[3];
+    for(unsigned k=0; k<3; ++k) nimg[k] = static_cast<int>(std::ceil(reach * reciprocal.getRow(k).modulo()));
+    shifts.clear();
+    for(int i=-nimg[0]; i<=nimg[0]; ++i)
+      for(int j=-nimg[1]; j<=nimg[1]; ++j)
+        for(int k=-nimg[2]; k<=nimg[2]; ++k)
+          shifts.push_back(i*box.getRow(0)+j*box.getRow(1)+k*box.getRow(2));
+  }
+
+  // overlaps of the atoms with the components assigned to this process.
+  // Each thread takes a contiguous block of atoms, so that concatenating
+  // the lists of the threads gives the pairs ordered by atom index
+  unsigned nt = OpenMP::getNumThreads();
+  std::vector< std::vector<unsigned> > pair_ids(nt), pair_atoms(nt);
+  std::vector< std::vector<double> > pair_ovs(nt);
+  #pragma omp parallel num_threads(nt)
+  {
+    const unsigned it = OpenMP::getThreadNum();
+    std::vector<unsigned> & my_ids = pair_ids[it];
+    std::vector<unsigned> & my_atoms = pair_atoms[it];
+    std::vector<double> & my_ovs = pair_ovs[it];
+    // last atom that visited each component, to skip components found twice
+    std::vector<unsigned> visited(GMM_d_size, std::numeric_limits<unsigned>::max());
+    #pragma omp for schedule(static)
+    for(unsigned im=0; im<GMM_m_size; ++im) {
+      const Vector & pos = getPosition(im);
+      const unsigned type = GMM_m_type_[im];
+      const double rcut = nl_rcut_[type];
+      Vector pos0 = pos;
+      if(pbc_) pos0 = center + pbcDistance(center, pos);
+      for(unsigned is=0; is<shifts.size(); ++is) {
+        const Vector x = pos0 + shifts[is];
+        // range of cells within the cutoff
+        int lo[3], hi[3];
+        bool inside = true;
+        for(unsigned k=0; k<3; ++k) {
+          const double xl = ( x[k] - rcut - cell_origin_[k] ) / cell_size_;
+          const double xh = ( x[k] + rcut - cell_origin_[k] ) / cell_size_;
+          if(xh < 0.0 || xl >= static_cast<double>(cell_n_[k])) { inside = false; break; }
+          lo[k] = std::max(0, static_cast<int>(std::floor(xl)));
+          hi[k] = std::min(static_cast<int>(cell_n_[k])-1, static_cast<int>(std::floor(xh)));
+        }
+        if(!inside) continue;
+        for(int cz=lo[2]; cz<=hi[2]; ++cz)
+          for(int cy=lo[1]; cy<=hi[1]; ++cy)
+            for(int cx=lo[0]; cx<=hi[0]; ++cx) {
+              const unsigned cell = cx + cell_n_[0] * ( cy + cell_n_[1] * cz );
+              for(unsigned ic=cell_starts_[cell]; ic<cell_starts_[cell+1]; ++ic) {
+                const unsigned id = cell_ids_[ic];
+                if(id%size_!=rank_ || visited[id]==im) continue;
+                visited[id] = im;
+                // get index in auxiliary lists
+                unsigned kaux = type * GMM_d_size + id;
+                // calculate exponent of overlap
+                double expov = get_exp_overlap(GMM_d_m_[id], pos, inv_cov_md_[kaux]);
+                // get index of 0.5*expov in tabulated exponential
+                unsigned itab = static_cast<unsigned> (round( 0.5*expov/dexp_ ));
+                // check boundaries and skip atom in case
+                if(itab >= tab_exp_.size()) continue;
+                // store overlap
+                my_ids.push_back(id);
+                my_atoms.push_back(im);
+                my_ovs.push_back(pre_fact_[kaux] * tab_exp_[itab]);
+              }
+            }
+      }
+    }
+  }
+
+  // group the pairs by component, keeping them ordered by atom index
+  std::vector<unsigned> starts(GMM_d_size+1, 0);
+  for(unsigned it=0; it<nt; ++it)
+    for(unsigned i=0; i<pair_ids[it].size(); ++i) starts[pair_ids[it][i]+1]++;
+  for(unsigned id=0; id<GMM_d_size; ++id) starts[id+1] += starts[id];
+  std::vector< std::pair<double,unsigned> > ov_l(starts[GMM_d_size]);
+  {
+    std::vector<unsigned> next(starts.begin(), starts.end()-1);
+    for(unsigned it=0; it<nt; ++it) {
+      for(unsigned i=0; i<pair_ids[it].size(); ++i)
+        ov_l[next[pair_ids[it][i]]++] = std::pair<double,unsigned>(pair_ovs[it][i], pair_atoms[it][i]);
+      std::vector<unsigned>().swap(pair_ids[it]);
+      std::vector<unsigned>().swap(pair_atoms[it]);
+      std::vector<double>().swap(pair_ovs[it]);
+    }
+  }
+
+  // cycle on GMM components - in parallel. The atoms that contribute less than the
+  // cutoff to the total overlap are discarded, the others are stored at the
+  // beginning of the block of the component in ascending atom index
+  std::vector<unsigned> kept(ov_l.size());
+  std::vector<unsigned> nkept(GMM_d_size, 0);
+  #pragma omp parallel for num_threads(nt) schedule(dynamic)
   for(unsigned id=rank_; id<GMM_d_size; id+=size_) {
-    // overlap lists and map
-    std::vector<double> ov_l;
-    std::map<double, unsigned> ov_m;
+    if(starts[id]==starts[id+1]) continue;
+    std::pair<double,unsigned> * first = &ov_l[starts[id]];
+    std::pair<double,unsigned> * last = first + (starts[id+1]-starts[id]);
     // total overlap with id
     double ov_tot = 0.0;
-    // cycle on all atoms
-    for(unsigned im=0; im<GMM_m_size; ++im) {
-      // get index in auxiliary lists
-      unsigned kaux = GMM_m_type_[im] * GMM_d_size + id;
-      // calculate exponent of overlap
-      double expov = get_exp_overlap(GMM_d_m_[id], getPosition(im), inv_cov_md_[kaux]);
-      // get index of 0.5*expov in tabulated exponential
-      unsigned itab = static_cast<unsigned> (round( 0.5*expov/dexp_ ));
-      // check boundaries and skip atom in case
-      if(itab >= tab_exp_.size()) continue;
-      // in case calculate overlap
-      double ov = pre_fact_[kaux] * tab_exp_[itab];
-      // add to list
-      ov_l.push_back(ov);
-      // and map to retrieve atom index
-      ov_m[ov] = im;
-      // increase ov_tot
-      ov_tot += ov;
-    }
-    // check if zero size -> ov_tot = 0
-    if(ov_l.size()==0) continue;
+    for(std::pair<double,unsigned> * it=first; it!=last; ++it) ov_tot += it->first;
     // define cutoff
     double ov_cut = ov_tot * nl_cutoff_;
-    // sort ov_l in ascending order
-    std::sort(ov_l.begin(), ov_l.end());
-    // integrate ov_l
+    // sort in ascending order of overlap, ties broken by atom index
+    std::sort(first, last);
+    // integrate overlaps
     double res = 0.0;
-    for(unsigned i=0; i<ov_l.size(); ++i) {
-      res += ov_l[i];
+    std::pair<double,unsigned> * keep = first;
+    for(; keep!=last; ++keep) {
+      res += keep->first;
       // if exceeding the cutoff for overlap, stop
       if(res >= ov_cut) break;
-      else ov_m.erase(ov_l[i]);
     }
-    // now add atoms to neighborlist
-    for(std::map<double, unsigned>::iterator it=ov_m.begin(); it!=ov_m.end(); ++it)
-      nl_l.push_back(id*GMM_m_size+it->second);
-    // end cycle on GMM components in parallel
+    // store the atoms to keep ordered by index
+    unsigned * my_kept = &kept[starts[id]];
+    nkept[id] = last - keep;
+    for(unsigned i=0; i<nkept[id]; ++i) my_kept[i] = keep[i].second;
+    std::sort(my_kept, my_kept+nkept[id]);
   }
+  // now add atoms to neighborlist
+  for(unsigned id=rank_; id<GMM_d_size; id+=size_)
+    for(unsigned i=0; i<nkept[id]; ++i)
+      nl_l.push_back(id*GMM_m_size+kept[starts[id]+i]);
   // find total dimension of neighborlist
   std::vector <int> recvcounts(size_, 0);
   recvcounts[rank_] = nl_l.size();
@@ -1371,15 +1540,22 @@ void EMMI::calculate_overlap() {
   // we have to cycle over all model and data GMM components in the neighbor list
   unsigned GMM_d_size = GMM_d_m_.size();
   unsigned GMM_m_size = GMM_m_type_.size();
-  for(unsigned i=rank_; i<nl_.size(); i=i+size_) {
-    // get data (id) and atom (im) indexes
-    unsigned id = nl_[i] / GMM_m_size;
-    unsigned im = nl_[i] % GMM_m_size;
-    // get index in auxiliary lists
-    unsigned kaux = GMM_m_type_[im] * GMM_d_size + id;
-    // add overlap with im component of model GMM
-    ovmd_[id] += get_overlap(GMM_d_m_[id], getPosition(im), pre_fact_[kaux],
-                             inv_cov_md_[kaux], ovmd_der_[i]);
+  #pragma omp parallel num_threads(OpenMP::getNumThreads())
+  {
+    std::vector<double> omp_ovmd(ovmd_.size(), 0.0);
+    #pragma omp for nowait
+    for(unsigned i=rank_; i<nl_.size(); i=i+size_) {
+      // get data (id) and atom (im) indexes
+      unsigned id = nl_[i] / GMM_m_size;
+      unsigned im = nl_[i] % GMM_m_size;
+      // get index in auxiliary lists
+      unsigned kaux = GMM_m_type_[im] * GMM_d_size + id;
+      // add overlap with im component of model GMM
+      omp_ovmd[id] += get_overlap(GMM_d_m_[id], getPosition(im), pre_fact_[kaux],
+                                  inv_cov_md_[kaux], ovmd_der_[i]);
+    }
+    #pragma omp critical
+    for(unsigned i=0; i<ovmd_.size(); ++i) ovmd_[i] += omp_ovmd[i];
   }
   // communicate stuff
   if(size_>1) {
@@ -1390,9 +1566,26 @@ void EMMI::calculate_overlap() {
 
 double EMMI::scaleEnergy(double s)
 {
+  // the sum of logarithms is calculated as the logarithm of the product.
+  // Mantissa and exponent of the product are kept separate to avoid overflows
+  const unsigned n = ovdd_.size();
+  const double ln2 = std::log(2.0);
+  unsigned nt = OpenMP::getNumThreads();
+  if(nt*4096>n) nt=1;
   double ene = 0.0;
-  for(unsigned i=0; i<ovdd_.size(); ++i) {
-    ene += std::log( abs ( s * ovmd_ave_[i] - ovdd_[i] ) );
+  #pragma omp parallel num_threads(nt) reduction(+:ene)
+  {
+    double prod = 1.0;
+    int expo = 0;
+    #pragma omp for nowait
+    for(unsigned i=0; i<n; i+=4) {
+      const unsigned last = std::min(i+4, n);
+      for(unsigned j=i; j<last; ++j) prod *= std::abs( s * ovmd_ave_[j] - ovdd_[j] );
+      int e;
+      prod = std::frexp(prod, &e);
+      expo += e;
+    }
+    ene += std::log(prod) + static_cast<double>(expo) * ln2;
   }
   return ene;
 }
@@ -1413,6 +1606,7 @@ double EMMI::doRegression()
   double ene = scaleEnergy(scale);
 // set best energy
   ebest = ene;
+  scale_best = scale;
 
 // MC loop
   for(unsigned istep=0; istep<MCsteps; ++istep) {
@@ -1629,18 +1823,29 @@ void EMMI::calculate()
   for(unsigned i=0; i<atom_der_.size(); ++i) atom_der_[i] = Vector(0,0,0);
 
   // get derivatives of bias with respect to atoms
-  for(unsigned i=rank_; i<nl_.size(); i=i+size_) {
-    // get indexes of data and model component
-    unsigned id = nl_[i] / GMM_m_type_.size();
-    unsigned im = nl_[i] % GMM_m_type_.size();
-    // chain rule + replica normalization
-    Vector tot_der = GMMid_der_av_[id] * ovmd_der_[i] * scale_ / anneal_;
-    Vector pos;
-    if(pbc_) pos = pbcDistance(GMM_d_m_[id], getPosition(im)) + GMM_d_m_[id];
-    else     pos = getPosition(im);
-    // increment derivatives and virial
-    atom_der_[im] += tot_der;
-    virial_ += Tensor(pos, -tot_der);
+  #pragma omp parallel num_threads(OpenMP::getNumThreads())
+  {
+    std::vector<Vector> omp_atom_der(atom_der_.size(), Vector(0,0,0));
+    Tensor omp_virial;
+    #pragma omp for nowait
+    for(unsigned i=rank_; i<nl_.size(); i=i+size_) {
+      // get indexes of data and model component
+      unsigned id = nl_[i] / GMM_m_type_.size();
+      unsigned im = nl_[i] % GMM_m_type_.size();
+      // chain rule + replica normalization
+      Vector tot_der = GMMid_der_av_[id] * ovmd_der_[i] * scale_ / anneal_;
+      Vector pos;
+      if(pbc_) pos = pbcDistance(GMM_d_m_[id], getPosition(im)) + GMM_d_m_[id];
+      else     pos = getPosition(im);
+      // increment derivatives and virial
+      omp_atom_der[im] += tot_der;
+      omp_virial += Tensor(pos, -tot_der);
+    }
+    #pragma omp critical
+    {
+      for(unsigned i=0; i<atom_der_.size(); ++i) atom_der_[i] += omp_atom_der[i];
+      virial_ += omp_virial;
+    }
   }
 
   // communicate local derivatives and virial
@@ -21,13 +21,10 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "MetainferenceBase.h"
 #include "tools/File.h"
+#include "tools/Stopwatch.h"
 #include <chrono>
 #include <numeric>
 
-#ifndef M_PI
-#define M_PI           3.14159265358979323846
-#endif
-
 namespace PLMD {
 namespace isdb {
 
@@ -42,6 +39,9 @@ void MetainferenceBase::registerKeywords( Keywords& keys ) {
   keys.addFlag("NOENSEMBLE",false,"don't perform any replica-averaging");
   keys.addFlag("REWEIGHT",false,"simple REWEIGHT using the ARG as energy");
   keys.add("optional","AVERAGING", "Stride for calculation of averaged weights and sigma_mean");
+  keys.addFlag("PACKED_COMMUNICATION",false,"sum the weights, the replica averages and, with OPTSIGMAMEAN, the variance of the averages over the replicas with a single collective operation");
+  keys.addFlag("FLOAT_COMMUNICATION",false,"use single precision for the packed communication among replicas, sending the differences from the replica averages of the previous step. Implies PACKED_COMMUNICATION, cannot be used with NUMERICAL_DERIVATIVES");
+  keys.addFlag("TIMINGS",false,"write in the log the time spent in the communication among replicas");
   keys.add("compulsory","NOISETYPE","MGAUSS","functional form of the noise (GAUSS,MGAUSS,OUTLIERS,MOUTLIERS,GENERIC)");
   keys.add("compulsory","LIKELIHOOD","GAUSS","the likelihood for the GENERIC metainference model, GAUSS or LOGN");
   keys.add("compulsory","DFTILDE","0.1","fraction of sigma_mean used to evolve ftilde");
@@ -68,6 +68,7 @@ void MetainferenceBase::registerKeywords( Keywords& keys ) {
   keys.add("optional","TEMP","the system temperature - this is only needed if code doesn't pass the temperature to plumed");
   keys.add("optional","MC_STEPS","number of MC steps");
   keys.add("optional","MC_CHUNKSIZE","MC chunksize");
+  keys.addFlag("MC_ASYNC",false,"do the MC moves on a separate thread, while the simulation continues. The parameters sampled at one step are used from the following one");
   keys.add("optional","STATUS_FILE","write a file with all the data useful for restart/continuation of Metainference");
   keys.add("compulsory","WRITE_STRIDE","10000","write the status to a file every N steps, this can be used for restart/continuation");
   keys.add("optional","SELECTOR","name of selector");
@@ -117,6 +118,7 @@ MetainferenceBase::MetainferenceBase(const ActionOptions&ao):
   MCacceptFT_(0),
   MCtrial_(0),
   MCchunksize_(0),
+  MCasync_(false),
   firstTime(true),
   do_reweight_(false),
   do_optsigmamean_(0),
@@ -126,7 +128,10 @@ MetainferenceBase::MetainferenceBase(const ActionOptions&ao):
   N_optimized_step_(0),
   optimized_step_(0),
   sigmamax_opt_done_(false),
-  decay_w_(1.)
+  decay_w_(1.),
+  packed_comm_(false),
+  float_comm_(false),
+  timers_(false)
 {
   parseFlag("DOSCORE", doscore_);
 
@@ -169,6 +174,22 @@ MetainferenceBase::MetainferenceBase(const ActionOptions&ao):
     optsigmamean_stride_ = averaging;
   }
 
+  parseFlag("PACKED_COMMUNICATION", packed_comm_);
+  parseFlag("FLOAT_COMMUNICATION", float_comm_);
+  if(float_comm_) packed_comm_ = true;
+  // the displacements used for numerical derivatives are lost in single precision
+  if(float_comm_ && checkNumericalDerivatives()) error("FLOAT_COMMUNICATION cannot be used with NUMERICAL_DERIVATIVES");
+  mean_ref_.resize(nsel_);
+  maxbias_ref_.resize(nsel_, 0.);
+  ref_step_.resize(nsel_, -1);
+  parseFlag("TIMINGS", timers_);
+  // the watches are only used by the master process of each replica, but they must exist
+  // on all the processes so that the same lines are written in the log
+  if(timers_) for(const std::string name : {"1 Replica averages","2 Replica MC energies","3 Replica forces"}) {
+      stopwatch.start(name);
+      stopwatch.pause(name);
+    }
+
   std::string stringa_noise;
   parse("NOISETYPE",stringa_noise);
   if(stringa_noise=="GAUSS")           noise_type_ = GAUSS;
@@ -321,6 +342,8 @@ MetainferenceBase::MetainferenceBase(const ActionOptions&ao):
   // monte carlo stuff
   parse("MC_STEPS",MCsteps_);
   parse("MC_CHUNKSIZE", MCchunksize_);
+  parseFlag("MC_ASYNC", MCasync_);
+  if(MCasync_&&(doscale_||dooffset_)) error("MC_ASYNC cannot be used together with SCALEDATA or ADDOFFSET");
   // get temperature
   double temp=0.0;
   parse("TEMP",temp);
@@ -369,7 +392,12 @@ MetainferenceBase::MetainferenceBase(const ActionOptions&ao):
 
 MetainferenceBase::~MetainferenceBase()
 {
+  if(MCthread_.joinable()) MCthread_.join();
   if(sfile_.isOpen()) sfile_.close();
+  if(timers_) {
+    log.printf("timings for action %s with label %s \n", getName().c_str(), getLabel().c_str() );
+    log<<stopwatch;
+  }
 }
 
 void MetainferenceBase::Initialise(const unsigned input)
@@ -666,6 +694,10 @@ void MetainferenceBase::Initialise(const unsigned input)
   log.printf("\n");
   log.printf("  temperature of the system %f\n",kbt_);
   log.printf("  MC steps %u\n",MCsteps_);
+  if(packed_comm_) {
+    log.printf("  weights and replica averages are summed over the replicas with a single collective operation\n");
+    if(float_comm_) log.printf("  using single precision for the differences from the replica averages of the previous step\n");
+  }
   log.printf("  initial standard errors of the mean");
   for(unsigned i=0; i<sigma_mean2_.size(); ++i) log.printf(" %f", std::sqrt(sigma_mean2_[i]));
   log.printf("\n");
@@ -721,25 +753,12 @@ double MetainferenceBase::getEnergySP(const std::vector<double> &mean, const std
 double MetainferenceBase::getEnergySPE(const std::vector<double> &mean, const std::vector<double> &sigma,
                                        const double scale, const double offset)
 {
-  const double scale2 = scale*scale;
   double ene = 0.0;
   #pragma omp parallel num_threads(OpenMP::getNumThreads()) shared(ene)
   {
     #pragma omp for reduction( + : ene)
     for(unsigned i=0; i<narg; ++i) {
-      const double sm2 = sigma_mean2_[i];
-      const double ss2 = sigma[i]*sigma[i] + scale2*sm2;
-      const double sss = sigma[i]*sigma[i] + sm2;
-      const double dev = scale*mean[i]-parameters[i]+offset;
-      const double a2  = 0.5*dev*dev + ss2;
-      if(sm2 > 0.0) {
-        ene += 0.5*std::log(sss) + 0.5*std::log(0.5*M_PI*M_PI/ss2) + std::log(2.0*a2/(1.0-std::exp(-a2/sm2)));
-      }
-      else {
-        ene += 0.5*std::log(sss) + 0.5*std::log(0.5*M_PI*M_PI/ss2) + std::log(2.0*a2);
-      }
-      if(doscale_ || doregres_zero_)  ene += 0.5*std::log(sss);
-      if(dooffset_) ene += 0.5*std::log(sss);
+      ene += getEnergyTermSPE(i, mean[i], sigma[i], scale, offset);
     }
   }
   return kbt_ * ene;
@@ -753,21 +772,7 @@ double MetainferenceBase::getEnergyMIGEN(const std::vector<double> &mean, const
   {
     #pragma omp for reduction( + : ene)
     for(unsigned i=0; i<narg; ++i) {
-      const double inv_sb2  = 1./(sigma[i]*sigma[i]);
-      const double inv_sm2  = 1./sigma_mean2_[i];
-      double devb = 0;
-      if(gen_likelihood_==LIKE_GAUSS)     devb = scale*ftilde[i]-parameters[i]+offset;
-      else if(gen_likelihood_==LIKE_LOGN) devb = std::log(scale*ftilde[i]/parameters[i]);
-      double devm = mean[i] - ftilde[i];
-      // deviation + normalisation + jeffrey
-      double normb = 0.;
-      if(gen_likelihood_==LIKE_GAUSS)     normb = -0.5*std::log(0.5/M_PI*inv_sb2);
-      else if(gen_likelihood_==LIKE_LOGN) normb = -0.5*std::log(0.5/M_PI*inv_sb2/(parameters[i]*parameters[i]));
-      const double normm         = -0.5*std::log(0.5/M_PI*inv_sm2);
-      const double jeffreys      = -0.5*std::log(2.*inv_sb2);
-      ene += 0.5*devb*devb*inv_sb2 + 0.5*devm*devm*inv_sm2 + normb + normm + jeffreys;
-      if(doscale_ || doregres_zero_)  ene += jeffreys;
-      if(dooffset_) ene += jeffreys;
+      ene += getEnergyTermMIGEN(i, mean[i], ftilde[i], sigma[i], scale, offset);
     }
   }
   return kbt_ * ene;
@@ -802,23 +807,68 @@ double MetainferenceBase::getEnergyGJ(const std::vector<double> &mean, const std
 double MetainferenceBase::getEnergyGJE(const std::vector<double> &mean, const std::vector<double> &sigma,
                                        const double scale, const double offset)
 {
-  const double scale2 = scale*scale;
-
   double ene = 0.0;
   #pragma omp parallel num_threads(OpenMP::getNumThreads()) shared(ene)
   {
     #pragma omp for reduction( + : ene)
     for(unsigned i=0; i<narg; ++i) {
-      const double inv_s2  = 1./(sigma[i]*sigma[i] + scale2*sigma_mean2_[i]);
-      const double inv_sss = 1./(sigma[i]*sigma[i] + sigma_mean2_[i]);
-      double dev = scale*mean[i]-parameters[i]+offset;
-      // deviation + normalisation + jeffrey
-      const double normalisation = -0.5*std::log(0.5/M_PI*inv_s2);
-      const double jeffreys      = -0.5*std::log(2.*inv_sss);
-      ene += 0.5*dev*dev*inv_s2 + normalisation + jeffreys;
-      if(doscale_ || doregres_zero_)  ene += jeffreys;
-      if(dooffset_) ene += jeffreys;
+      ene += getEnergyTermGJE(i, mean[i], sigma[i], scale, offset);
+    }
+  }
+  return kbt_ * ene;
+}
+
+double MetainferenceBase::getEnergy(const std::vector<double> &mean, const std::vector<double> &sigma,
+                                    const double scale, const double offset)
+{
+  double ene = 0.;
+  switch(noise_type_) {
+  case GAUSS:
+    ene = getEnergyGJ(mean,sigma,scale,offset);
+    break;
+  case MGAUSS:
+    ene = getEnergyGJE(mean,sigma,scale,offset);
+    break;
+  case OUTLIERS:
+    ene = getEnergySP(mean,sigma,scale,offset);
+    break;
+  case MOUTLIERS:
+    ene = getEnergySPE(mean,sigma,scale,offset);
+    break;
+  case GENERIC:
+    ene = getEnergyMIGEN(mean,ftilde_,sigma,scale,offset);
+    break;
+  }
+  return ene;
+}
+
+// energy of the data points indices[first] ... indices[last-1] with the current parameters,
+// only for noise models with one sigma per data point
+double MetainferenceBase::getEnergyChunk(const std::vector<double> &mean, const std::vector<unsigned> &indices,
+    const unsigned first, const unsigned last) const
+{
+  double ene = 0.0;
+  switch(noise_type_) {
+  case MGAUSS:
+    for(unsigned k=first; k<last; ++k) {
+      const unsigned i = indices[k];
+      ene += getEnergyTermGJE(i, mean[i], sigma_[i], scale_, offset_);
+    }
+    break;
+  case MOUTLIERS:
+    for(unsigned k=first; k<last; ++k) {
+      const unsigned i = indices[k];
+      ene += getEnergyTermSPE(i, mean[i], sigma_[i], scale_, offset_);
     }
+    break;
+  case GENERIC:
+    for(unsigned k=first; k<last; ++k) {
+      const unsigned i = indices[k];
+      ene += getEnergyTermMIGEN(i, mean[i], ftilde_[i], sigma_[i], scale_, offset_);
+    }
+    break;
+  default:
+    plumed_merror("energy of a chunk of data points requires one sigma per data point");
   }
   return kbt_ * ene;
 }
@@ -892,32 +942,18 @@ void MetainferenceBase::moveScaleOffset(const std::vector<double> &mean_, double
   }
 
   // calculate new energy
-  double new_energy = 0.;
-
-  switch(noise_type_) {
-  case GAUSS:
-    new_energy = getEnergyGJ(mean_,sigma_,new_scale,new_offset);
-    break;
-  case MGAUSS:
-    new_energy = getEnergyGJE(mean_,sigma_,new_scale,new_offset);
-    break;
-  case OUTLIERS:
-    new_energy = getEnergySP(mean_,sigma_,new_scale,new_offset);
-    break;
-  case MOUTLIERS:
-    new_energy = getEnergySPE(mean_,sigma_,new_scale,new_offset);
-    break;
-  case GENERIC:
-    new_energy = getEnergyMIGEN(mean_,ftilde_,sigma_,new_scale,new_offset);
-    break;
-  }
+  double new_energy = getEnergy(mean_,sigma_,new_scale,new_offset);
 
   // for the scale/offset we need to consider the total energy
   std::vector<double> totenergies(2);
   if(master) {
     totenergies[0] = old_energy;
     totenergies[1] = new_energy;
-    if(nrep_>1) multi_sim_comm.Sum(totenergies);
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("2 Replica MC energies");
+      multi_sim_comm.Sum(totenergies);
+      if(timers_) stopwatch.stop("2 Replica MC energies");
+    }
   } else {
     totenergies[0] = 0;
     totenergies[1] = 0;
@@ -946,16 +982,37 @@ void MetainferenceBase::moveScaleOffset(const std::vector<double> &mean_, double
 
 void MetainferenceBase::moveSigmas(const std::vector<double> &mean_, double &old_energy, const unsigned i, const std::vector<unsigned> &indices, bool &breaknow)
 {
-  std::vector<double> new_sigma(sigma_.size());
-  new_sigma = sigma_;
-
   // change MCchunksize_ sigmas
   if (MCchunksize_ > 0) {
     if ((MCchunksize_ * i) >= sigma_.size()) {
       // This means we are not moving any sigma, so we should break immediately
       breaknow = true;
+      return;
+    }
+    const unsigned first = MCchunksize_ * i;
+    const unsigned last = std::min(first + MCchunksize_, static_cast<unsigned>(sigma_.size()));
+
+    // with one sigma per data point only the energy of the chunk changes
+    if(noise_type_==MGAUSS||noise_type_==MOUTLIERS||noise_type_==GENERIC) {
+      std::vector<double> r(last-first), old_sigma(last-first);
+      for(unsigned j=0; j<r.size(); j++) r[j] = random[0].Gaussian();
+      const double dene = proposeSigmaChunk(mean_, indices, first, last, r.data(), old_sigma);
+      // accept or reject
+      const double delta = dene / kbt_;
+      if( delta <= 0.0 || random[0].RandU01() < std::exp(-delta) ) {
+        old_energy += dene;
+        MCaccept_++;
+      } else {
+        rejectSigmaChunk(indices, first, last, old_sigma);
+      }
+      return;
     }
+  }
+
+  std::vector<double> new_sigma(sigma_.size());
+  new_sigma = sigma_;
 
+  if (MCchunksize_ > 0) {
     // change random sigmas
     for(unsigned j=0; j<MCchunksize_; j++) {
       const unsigned shuffle_index = j + MCchunksize_ * i;
@@ -983,30 +1040,8 @@ void MetainferenceBase::moveSigmas(const std::vector<double> &mean_, double &old
     }
   }
 
-  if (breaknow) {
-    // We didnt move any sigmas, so no sense in evaluating anything
-    return;
-  }
-
   // calculate new energy
-  double new_energy = 0.;
-  switch(noise_type_) {
-  case GAUSS:
-    new_energy = getEnergyGJ(mean_,new_sigma,scale_,offset_);
-    break;
-  case MGAUSS:
-    new_energy = getEnergyGJE(mean_,new_sigma,scale_,offset_);
-    break;
-  case OUTLIERS:
-    new_energy = getEnergySP(mean_,new_sigma,scale_,offset_);
-    break;
-  case MOUTLIERS:
-    new_energy = getEnergySPE(mean_,new_sigma,scale_,offset_);
-    break;
-  case GENERIC:
-    new_energy = getEnergyMIGEN(mean_,ftilde_,new_sigma,scale_,offset_);
-    break;
-  }
+  double new_energy = getEnergy(mean_,new_sigma,scale_,offset_);
 
   // accept or reject
   const double delta = ( new_energy - old_energy ) / kbt_;
@@ -1026,78 +1061,173 @@ void MetainferenceBase::moveSigmas(const std::vector<double> &mean_, double &old
   }
 }
 
-double MetainferenceBase::doMonteCarlo(const std::vector<double> &mean_)
+// move the sigmas indices[first] ... indices[last-1] using the gaussian random numbers r,
+// store their old values in old_sigma and return the change in energy
+double MetainferenceBase::proposeSigmaChunk(const std::vector<double> &mean_, const std::vector<unsigned> &indices,
+    const unsigned first, const unsigned last, const double *r, std::vector<double> &old_sigma)
 {
-  // calculate old energy with the updated coordinates
-  double old_energy=0.;
+  const double old_energy = getEnergyChunk(mean_, indices, first, last);
+  for(unsigned k=first; k<last; k++) {
+    const unsigned index = indices[k];
+    old_sigma[k-first] = sigma_[index];
+    double new_sigma = sigma_[index] + Dsigma_[index]*r[k-first];
+    // check boundaries
+    if(new_sigma > sigma_max_[index]) {new_sigma = 2.0 * sigma_max_[index] - new_sigma;}
+    if(new_sigma < sigma_min_[index]) {new_sigma = 2.0 * sigma_min_[index] - new_sigma;}
+    sigma_[index] = new_sigma;
+  }
+  return getEnergyChunk(mean_, indices, first, last) - old_energy;
+}
 
-  switch(noise_type_) {
-  case GAUSS:
-    old_energy = getEnergyGJ(mean_,sigma_,scale_,offset_);
-    break;
-  case MGAUSS:
-    old_energy = getEnergyGJE(mean_,sigma_,scale_,offset_);
-    break;
-  case OUTLIERS:
-    old_energy = getEnergySP(mean_,sigma_,scale_,offset_);
-    break;
-  case MOUTLIERS:
-    old_energy = getEnergySPE(mean_,sigma_,scale_,offset_);
-    break;
-  case GENERIC:
-    old_energy = getEnergyMIGEN(mean_,ftilde_,sigma_,scale_,offset_);
-    break;
+void MetainferenceBase::rejectSigmaChunk(const std::vector<unsigned> &indices, const unsigned first, const unsigned last,
+    const std::vector<double> &old_sigma)
+{
+  for(unsigned k=first; k<last; k++) sigma_[indices[k]] = old_sigma[k-first];
+}
+
+// When only the sigmas are sampled and there is one sigma per data point, moves of different
+// chunks are independent and are done in parallel. Random numbers are extracted in advance,
+// so that the result does not depend on the number of threads
+void MetainferenceBase::moveSigmaChunks(const std::vector<double> &mean_, double &old_energy, const std::vector<unsigned> &indices)
+{
+  const unsigned nsigma = sigma_.size();
+  const unsigned nchunks = std::min(MCsteps_, (nsigma+MCchunksize_-1)/MCchunksize_);
+  const unsigned nmoved = std::min(nsigma, nchunks*MCchunksize_);
+  std::vector<double> r(nmoved), u(nchunks);
+  for(unsigned c=0; c<nchunks; c++) {
+    for(unsigned k=c*MCchunksize_; k<std::min(nmoved, (c+1)*MCchunksize_); k++) r[k] = random[0].Gaussian();
+    u[c] = random[0].RandU01();
   }
 
-  // do not run MC if this is a replica-exchange trial
-  if(!getExchangeStep()) {
+  unsigned nt = OpenMP::getNumThreads();
+  if(nt*2>nchunks) nt=1;
 
-    // Create std::vector of random sigma indices
-    std::vector<unsigned> indices;
-    if (MCchunksize_ > 0) {
-      for (unsigned j=0; j<sigma_.size(); j++) {
-        indices.push_back(j);
+  double dene = 0.;
+  unsigned naccept = 0;
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<double> old_sigma(MCchunksize_);
+    #pragma omp for reduction(+:dene,naccept) schedule(dynamic)
+    for(unsigned c=0; c<nchunks; c++) {
+      const unsigned first = c*MCchunksize_;
+      const unsigned last = std::min(nmoved, first+MCchunksize_);
+      const double de = proposeSigmaChunk(mean_, indices, first, last, &r[first], old_sigma);
+      // accept or reject
+      const double delta = de / kbt_;
+      if( delta <= 0.0 || u[c] < std::exp(-delta) ) {
+        dene += de;
+        naccept++;
+      } else {
+        rejectSigmaChunk(indices, first, last, old_sigma);
       }
-      random[2].Shuffle(indices);
-    }
-    bool breaknow = false;
-
-    // cycle on MC steps
-    for(unsigned i=0; i<MCsteps_; ++i) {
-      MCtrial_++;
-      // propose move for ftilde
-      if(noise_type_==GENERIC) moveTilde(mean_, old_energy);
-      // propose move for scale and/or offset
-      if(doscale_||dooffset_) moveScaleOffset(mean_, old_energy);
-      // propose move for sigma
-      moveSigmas(mean_, old_energy, i, indices, breaknow);
-      // exit from the loop if this is the case
-      if(breaknow) break;
-    }
-
-    /* save the result of the sampling */
-    /* ftilde */
-    if(noise_type_==GENERIC) {
-      double accept = static_cast<double>(MCacceptFT_) / static_cast<double>(MCtrial_);
-      valueAcceptFT->set(accept);
-      for(unsigned i=0; i<sigma_.size(); i++) valueFtilde[i]->set(ftilde_[i]);
-    }
-    /* scale and offset */
-    if(doscale_ || doregres_zero_) valueScale->set(scale_);
-    if(dooffset_) valueOffset->set(offset_);
-    if(doscale_||dooffset_) {
-      double accept = static_cast<double>(MCacceptScale_) / static_cast<double>(MCtrial_);
-      valueAcceptScale->set(accept);
-    }
-    /* sigmas */
-    for(unsigned i=0; i<sigma_.size(); i++) valueSigma[i]->set(sigma_[i]);
-    double accept = static_cast<double>(MCaccept_) / static_cast<double>(MCtrial_);
-    valueAccept->set(accept);
+    }
+  }
+  old_energy += dene;
+  MCaccept_ += naccept;
+  // as in the serial loop, the step that finds no more chunks to move is counted as a trial
+  MCtrial_ += (MCsteps_>nchunks) ? nchunks+1 : nchunks;
+}
+
+void MetainferenceBase::runMonteCarlo(const std::vector<double> &mean_, double &old_energy)
+{
+  // Create std::vector of random sigma indices
+  std::vector<unsigned> indices;
+  if (MCchunksize_ > 0) {
+    for (unsigned j=0; j<sigma_.size(); j++) {
+      indices.push_back(j);
+    }
+    random[2].Shuffle(indices);
+  }
+
+  if(MCchunksize_>0 && (noise_type_==MGAUSS||noise_type_==MOUTLIERS) && !doscale_ && !dooffset_) {
+    moveSigmaChunks(mean_, old_energy, indices);
+    return;
+  }
+
+  bool breaknow = false;
+
+  // cycle on MC steps
+  for(unsigned i=0; i<MCsteps_; ++i) {
+    MCtrial_++;
+    // propose move for ftilde
+    if(noise_type_==GENERIC) moveTilde(mean_, old_energy);
+    // propose move for scale and/or offset
+    if(doscale_||dooffset_) moveScaleOffset(mean_, old_energy);
+    // propose move for sigma
+    moveSigmas(mean_, old_energy, i, indices, breaknow);
+    // exit from the loop if this is the case
+    if(breaknow) break;
+  }
+}
+
+void MetainferenceBase::setMonteCarloValues()
+{
+  /* save the result of the sampling */
+  /* ftilde */
+  if(noise_type_==GENERIC) {
+    double accept = static_cast<double>(MCacceptFT_) / static_cast<double>(MCtrial_);
+    valueAcceptFT->set(accept);
+    for(unsigned i=0; i<sigma_.size(); i++) valueFtilde[i]->set(ftilde_[i]);
+  }
+  /* scale and offset */
+  if(doscale_ || doregres_zero_) valueScale->set(scale_);
+  if(dooffset_) valueOffset->set(offset_);
+  if(doscale_||dooffset_) {
+    double accept = static_cast<double>(MCacceptScale_) / static_cast<double>(MCtrial_);
+    valueAcceptScale->set(accept);
+  }
+  /* sigmas */
+  for(unsigned i=0; i<sigma_.size(); i++) valueSigma[i]->set(sigma_[i]);
+  double accept = static_cast<double>(MCaccept_) / static_cast<double>(MCtrial_);
+  valueAccept->set(accept);
+}
+
+// With MC_ASYNC the MC moves are done on a helper thread, while the simulation continues.
+// The helper thread only works on a copy of the averages and on the parameters, which are not
+// used until waitMonteCarlo() is called at the beginning of the following step
+void MetainferenceBase::startMonteCarlo(const std::vector<double> &mean_)
+{
+  MCmean_ = mean_;
+  MCthread_ = std::thread([this]() {
+    try {
+      double energy = getEnergy(MCmean_,sigma_,scale_,offset_);
+      runMonteCarlo(MCmean_, energy);
+    } catch(...) {
+      MCexception_ = std::current_exception();
+    }
+  });
+}
+
+void MetainferenceBase::waitMonteCarlo()
+{
+  if(!MCthread_.joinable()) return;
+  MCthread_.join();
+  if(MCexception_) {
+    std::exception_ptr e = MCexception_;
+    MCexception_ = nullptr;
+    std::rethrow_exception(e);
+  }
+  setMonteCarloValues();
+}
+
+double MetainferenceBase::doMonteCarlo(const std::vector<double> &mean_)
+{
+  // calculate old energy with the updated coordinates
+  double old_energy = getEnergy(mean_,sigma_,scale_,offset_);
+
+  // do not run MC if this is a replica-exchange trial, with MC_ASYNC this is done later
+  if(!getExchangeStep() && !MCasync_) {
+    runMonteCarlo(mean_, old_energy);
+    setMonteCarloValues();
   }
 
   // here we sum the score over the replicas to get the full metainference score that we save as a bias
   if(master) {
-    if(nrep_>1) multi_sim_comm.Sum(old_energy);
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("2 Replica MC energies");
+      multi_sim_comm.Sum(old_energy);
+      if(timers_) stopwatch.stop("2 Replica MC energies");
+    }
   } else {
     old_energy=0;
   }
@@ -1140,7 +1270,11 @@ void MetainferenceBase::getEnergyForceSP(const std::vector<double> &mean, const
       }
     }
     // collect contribution to forces and energy from other replicas
-    if(nrep_>1) multi_sim_comm.Sum(&f[0],narg);
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("3 Replica forces");
+      multi_sim_comm.Sum(&f[0],narg);
+      if(timers_) stopwatch.stop("3 Replica forces");
+    }
   }
   // intra-replica summation
   comm.Sum(&f[0],narg);
@@ -1184,7 +1318,11 @@ void MetainferenceBase::getEnergyForceSPE(const std::vector<double> &mean, const
       }
     }
     // collect contribution to forces and energy from other replicas
-    if(nrep_>1) multi_sim_comm.Sum(&f[0],narg);
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("3 Replica forces");
+      multi_sim_comm.Sum(&f[0],narg);
+      if(timers_) stopwatch.stop("3 Replica forces");
+    }
   }
   comm.Sum(&f[0],narg);
 
@@ -1208,7 +1346,11 @@ void MetainferenceBase::getEnergyForceGJ(const std::vector<double> &mean, const
 
   if(master) {
     inv_s2 = 1./(sigma_[0]*sigma_[0] + scale2*sigma_mean2_[0]);
-    if(nrep_>1) multi_sim_comm.Sum(inv_s2);
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("3 Replica forces");
+      multi_sim_comm.Sum(inv_s2);
+      if(timers_) stopwatch.stop("3 Replica forces");
+    }
   }
   comm.Sum(inv_s2);
 
@@ -1238,7 +1380,11 @@ void MetainferenceBase::getEnergyForceGJE(const std::vector<double> &mean, const
 
   if(master) {
     for(unsigned i=0; i<sigma_.size(); ++i) inv_s2[i] = 1./(sigma_[i]*sigma_[i] + scale2*sigma_mean2_[i]);
-    if(nrep_>1) multi_sim_comm.Sum(&inv_s2[0],sigma_.size());
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("3 Replica forces");
+      multi_sim_comm.Sum(&inv_s2[0],sigma_.size());
+      if(timers_) stopwatch.stop("3 Replica forces");
+    }
   }
   comm.Sum(&inv_s2[0],sigma_.size());
 
@@ -1264,21 +1410,17 @@ void MetainferenceBase::getEnergyForceMIGEN(const std::vector<double> &mean, con
 {
   std::vector<double> inv_s2(sigma_.size(),0.);
   std::vector<double> dev(sigma_.size(),0.);
-  std::vector<double> dev2(sigma_.size(),0.);
 
   for(unsigned i=0; i<sigma_.size(); ++i) {
     inv_s2[i]   = 1./sigma_mean2_[i];
-    if(master) {
-      dev[i]  = (mean[i]-ftilde_[i]);
-      dev2[i] = dev[i]*dev[i];
-    }
+    if(master) dev[i] = (mean[i]-ftilde_[i]);
   }
   if(master&&nrep_>1) {
+    if(timers_) stopwatch.start("3 Replica forces");
     multi_sim_comm.Sum(&dev[0],dev.size());
-    multi_sim_comm.Sum(&dev2[0],dev2.size());
+    if(timers_) stopwatch.stop("3 Replica forces");
   }
   comm.Sum(&dev[0],dev.size());
-  comm.Sum(&dev2[0],dev2.size());
 
   double dene_b = 0.;
   #pragma omp parallel num_threads(OpenMP::getNumThreads()) shared(dene_b)
@@ -1305,7 +1447,11 @@ void MetainferenceBase::get_weights(double &weight, double &norm, double &neff)
     std::vector<double> bias(nrep_,0);
     if(master) {
       bias[replica_] = getArgument(0);
-      if(nrep_>1) multi_sim_comm.Sum(&bias[0], nrep_);
+      if(nrep_>1) {
+        if(timers_) stopwatch.start("1 Replica averages");
+        multi_sim_comm.Sum(&bias[0], nrep_);
+        if(timers_) stopwatch.stop("1 Replica averages");
+      }
     }
     comm.Sum(&bias[0], nrep_);
 
@@ -1341,7 +1487,8 @@ void MetainferenceBase::get_weights(double &weight, double &norm, double &neff)
   getPntrToComponent("neff")->set(neff);
 }
 
-void MetainferenceBase::get_sigma_mean(const double weight, const double norm, const double neff, const std::vector<double> &mean)
+void MetainferenceBase::get_sigma_mean(const double weight, const double norm, const double neff, const std::vector<double> &mean,
+                                       std::vector<double> &sigma_mean2_now)
 {
   const double dnrep    = static_cast<double>(nrep_);
   std::vector<double> sigma_mean2_tmp(sigma_mean2_.size());
@@ -1353,12 +1500,19 @@ void MetainferenceBase::get_sigma_mean(const double weight, const double norm, c
     /* this is the current estimate of sigma mean for each argument
        there is one of this per argument in any case  because it is
        the maximum among these to be used in case of GAUSS/OUTLIER */
-    std::vector<double> sigma_mean2_now(narg,0);
-    if(master) {
-      for(unsigned i=0; i<narg; ++i) sigma_mean2_now[i] = weight*(calc_data_[i]-mean[i])*(calc_data_[i]-mean[i]);
-      if(nrep_>1) multi_sim_comm.Sum(&sigma_mean2_now[0], narg);
+    // with packed communication this is already summed over the replicas
+    if(sigma_mean2_now.empty()) {
+      sigma_mean2_now.resize(narg,0);
+      if(master) {
+        for(unsigned i=0; i<narg; ++i) sigma_mean2_now[i] = weight*(calc_data_[i]-mean[i])*(calc_data_[i]-mean[i]);
+        if(nrep_>1) {
+          if(timers_) stopwatch.start("1 Replica averages");
+          multi_sim_comm.Sum(&sigma_mean2_now[0], narg);
+          if(timers_) stopwatch.stop("1 Replica averages");
+        }
+      }
+      comm.Sum(&sigma_mean2_now[0], narg);
     }
-    comm.Sum(&sigma_mean2_now[0], narg);
     for(unsigned i=0; i<narg; ++i) sigma_mean2_now[i] *= 1.0/(neff-1.)/norm;
 
     // add sigma_mean2 to history
@@ -1422,18 +1576,113 @@ void MetainferenceBase::get_sigma_mean(const double weight, const double norm, c
   sigma_mean2_ = sigma_mean2_tmp;
 }
 
-void MetainferenceBase::replica_averaging(const double weight, const double norm, std::vector<double> &mean, std::vector<double> &dmean_b)
+void MetainferenceBase::replica_averaging(const double weight, const double norm, std::vector<double> &mean)
 {
   if(master) {
     for(unsigned i=0; i<narg; ++i) mean[i] = weight/norm*calc_data_[i];
-    if(nrep_>1) multi_sim_comm.Sum(&mean[0], narg);
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("1 Replica averages");
+      multi_sim_comm.Sum(&mean[0], narg);
+      if(timers_) stopwatch.stop("1 Replica averages");
+    }
   }
   comm.Sum(&mean[0], narg);
-  // set the derivative of the mean with respect to the bias
-  for(unsigned i=0; i<narg; ++i) dmean_b[i] = weight/norm/kbt_*(calc_data_[i]-mean[i])*decay_w_;
+}
 
-  // this is only for generic metainference
-  if(firstTime) {ftilde_ = mean; firstTime = false;}
+/*
+   Weights, averages and, with OPTSIGMAMEAN, the variances of the averages are summed over
+   the replicas with a single collective. In order to do so the data are sent as differences
+   from the averages at the previous step, and the weights are computed with respect to the
+   maximum averaged bias at the previous step. The averaged biases are sent in the same buffer,
+   so that the weights can be normalized afterwards. Returns false if the sums cannot be done
+   in this way (first step or large change in the averaged biases), so that the standard
+   communication is used instead.
+*/
+template<typename T>
+bool MetainferenceBase::replica_averaging_packed(std::vector<T> &buffer, double &weight, double &norm, double &neff,
+    std::vector<double> &mean, std::vector<double> &sigma_mean2_now)
+{
+  std::vector<double> & ref = mean_ref_[iselect];
+  if(ref.size()!=narg) return false;
+  const bool update_ref = getStep()!=ref_step_[iselect];
+  if(do_reweight_&&firstTimeW[iselect]) return false;
+
+  // exponents larger than this would overflow the buffer in single precision
+  const double maxexp = 40.;
+  const unsigned nw = do_reweight_ ? nrep_ : 0;
+  const bool dovar = do_optsigmamean_>0;
+  buffer.assign(nw+(dovar?2:1)*narg,0);
+
+  // updated averaged bias of this replica
+  double abias = 0.;
+  if(master) {
+    double u = 1.;
+    if(do_reweight_) {
+      abias = average_weights_[iselect][replica_]+decay_w_*(getArgument(0)-average_weights_[iselect][replica_]);
+      const double x = (abias-maxbias_ref_[iselect])/kbt_;
+      buffer[replica_] = x;
+      u = (x<maxexp) ? std::exp(x) : 0.;
+    }
+    T* d = &buffer[nw];
+    T* d2 = &buffer[nw+narg];
+    for(unsigned i=0; i<narg; ++i) {
+      const double di = calc_data_[i]-ref[i];
+      d[i] = u*di;
+      if(dovar) d2[i] = u*di*di;
+    }
+    if(nrep_>1) {
+      if(timers_) stopwatch.start("1 Replica averages");
+      multi_sim_comm.Sum(&buffer[0], buffer.size());
+      if(timers_) stopwatch.stop("1 Replica averages");
+    }
+  }
+  comm.Sum(&buffer[0], buffer.size());
+
+  // unnormalized sum of the weights used in the buffer and scaling to the normalized weights
+  double usum = static_cast<double>(nrep_);
+  double wscale = 1.;
+  if(do_reweight_) {
+    double xmax = buffer[0];
+    for(unsigned r=1; r<nrep_; ++r) xmax = std::max(xmax, static_cast<double>(buffer[r]));
+    if(xmax>=maxexp || xmax<=-maxexp) return false;
+    usum = 0.;
+    norm = 0.;
+    double w2 = 0.;
+    for(unsigned r=0; r<nrep_; ++r) {
+      usum += std::exp(static_cast<double>(buffer[r]));
+      const double w = std::exp(buffer[r]-xmax);
+      norm += w;
+      w2 += w*w;
+    }
+    weight = std::exp(buffer[replica_]-xmax);
+    neff = norm*norm/w2;
+    wscale = std::exp(-xmax);
+    // store the averaged biases
+    for(unsigned r=0; r<nrep_; ++r) average_weights_[iselect][r] = maxbias_ref_[iselect]+kbt_*buffer[r];
+    comm.Sum(&abias, 1);
+    average_weights_[iselect][replica_] = abias;
+    if(update_ref) maxbias_ref_[iselect] += kbt_*xmax;
+    getPntrToComponent("weight")->set(weight/norm);
+  } else {
+    weight = 1.0;
+    norm = usum;
+    neff = usum;
+  }
+  getPntrToComponent("neff")->set(neff);
+
+  const T* d = &buffer[nw];
+  const T* d2 = &buffer[nw+narg];
+  if(dovar) sigma_mean2_now.resize(narg);
+  for(unsigned i=0; i<narg; ++i) {
+    const double delta = d[i]/usum;
+    mean[i] = ref[i]+delta;
+    if(dovar) sigma_mean2_now[i] = std::max(wscale*(d2[i]-usum*delta*delta), 0.);
+  }
+  if(update_ref) {
+    ref = mean;
+    ref_step_[iselect] = getStep();
+  }
+  return true;
 }
 
 void MetainferenceBase::do_regression_zero(const std::vector<double> &mean)
@@ -1454,24 +1703,45 @@ void MetainferenceBase::do_regression_zero(const std::vector<double> &mean)
 
 double MetainferenceBase::getScore()
 {
+  // the MC moves started at the previous step must be completed before using the parameters
+  waitMonteCarlo();
+
   /* Metainference */
-  /* 1) collect weights */
   double weight = 0.;
   double neff = 0.;
   double norm = 0.;
-  get_weights(weight, norm, neff);
-
-  /* 2) calculate average */
   std::vector<double> mean(getNarg(),0);
+  // with packed communication this is calculated together with the average
+  std::vector<double> sigma_mean2_now;
+  bool packed = false;
+  if(packed_comm_) {
+    if(float_comm_) packed = replica_averaging_packed(packed_buffer_float_, weight, norm, neff, mean, sigma_mean2_now);
+    else            packed = replica_averaging_packed(packed_buffer_, weight, norm, neff, mean, sigma_mean2_now);
+  }
+  if(!packed) {
+    /* 1) collect weights */
+    get_weights(weight, norm, neff);
+    /* 2) calculate average */
+    replica_averaging(weight, norm, mean);
+    if(packed_comm_ && getStep()!=ref_step_[iselect]) {
+      // set the references for the packed communication at the next step
+      mean_ref_[iselect] = mean;
+      if(do_reweight_) maxbias_ref_[iselect] = *std::max_element(average_weights_[iselect].begin(), average_weights_[iselect].end());
+      ref_step_[iselect] = getStep();
+    }
+  }
+
   // this is the derivative of the mean with respect to the argument
   std::vector<double> dmean_x(getNarg(),weight/norm);
   // this is the derivative of the mean with respect to the bias
   std::vector<double> dmean_b(getNarg(),0);
-  // calculate it
-  replica_averaging(weight, norm, mean, dmean_b);
+  for(unsigned i=0; i<narg; ++i) dmean_b[i] = weight/norm/kbt_*(calc_data_[i]-mean[i])*decay_w_;
+
+  // this is only for generic metainference
+  if(firstTime) {ftilde_ = mean; firstTime = false;}
 
   /* 3) calculates parameters */
-  get_sigma_mean(weight, norm, neff, mean);
+  get_sigma_mean(weight, norm, neff, mean, sigma_mean2_now);
 
   // in case of regression with zero intercept, calculate scale
   if(doregres_zero_ && getStep()%nregres_zero_==0) do_regression_zero(mean);
@@ -1498,12 +1768,16 @@ double MetainferenceBase::getScore()
     break;
   }
 
+  // the parameters can be changed only after the forces are calculated
+  if(MCasync_ && !getExchangeStep()) startMonteCarlo(mean);
+
   return ene;
 }
 
 void MetainferenceBase::writeStatus()
 {
   if(!doscore_) return;
+  waitMonteCarlo();
   sfile_.rewind();
   sfile_.printField("time",getTimeStep()*getStep());
   //nsel
@@ -28,10 +28,21 @@
 #include "core/PlumedMain.h"
 #include "tools/Random.h"
 #include "tools/OpenMP.h"
+#include "tools/ForwardDecl.h"
+#include <cmath>
+#include <thread>
+#include <exception>
+
+#ifndef M_PI
+#define M_PI           3.14159265358979323846
+#endif
 
 #define PLUMED_METAINF_INIT(ao) Action(ao),MetainferenceBase(ao)
 
 namespace PLMD {
+
+class Stopwatch;
+
 namespace isdb {
 
 /**
@@ -108,6 +119,11 @@ private:
   long long unsigned MCacceptFT_;
   long long unsigned MCtrial_;
   unsigned MCchunksize_;
+  // Monte Carlo done on a helper thread
+  bool MCasync_;
+  std::thread MCthread_;
+  std::exception_ptr MCexception_;
+  std::vector<double> MCmean_;
 
   // output
   Value*   valueScore;
@@ -151,6 +167,23 @@ private:
   double decay_w_;
   std::vector< std::vector <double> >  average_weights_;
 
+  // packed inter-replica communication
+  bool packed_comm_;
+  bool float_comm_;
+  // replica averages and maximum averaged bias of the last step, used as reference for the packed sums
+  std::vector< std::vector <double> > mean_ref_;
+  std::vector<double> maxbias_ref_;
+  // step at which the references were last set, they are not changed by the evaluations
+  // on displaced positions done in the same step for numerical derivatives
+  std::vector<long long int> ref_step_;
+  std::vector<double> packed_buffer_;
+  std::vector<float>  packed_buffer_float_;
+
+  // timings of inter-replica communication
+  bool timers_;
+  ForwardDecl<Stopwatch> stopwatch_fwd;
+  Stopwatch& stopwatch=*stopwatch_fwd;
+
   double getEnergyMIGEN(const std::vector<double> &mean, const std::vector<double> &ftilde, const std::vector<double> &sigma,
                         const double scale, const double offset);
   double getEnergySP(const std::vector<double> &mean, const std::vector<double> &sigma,
@@ -161,6 +194,17 @@ private:
                      const double scale, const double offset);
   double getEnergyGJE(const std::vector<double> &mean, const std::vector<double> &sigma,
                       const double scale, const double offset);
+  // contributions of single data points for noise models with one sigma per data point
+  double getEnergyTermMIGEN(const unsigned i, const double mean, const double ftilde, const double sigma,
+                            const double scale, const double offset) const;
+  double getEnergyTermSPE(const unsigned i, const double mean, const double sigma,
+                          const double scale, const double offset) const;
+  double getEnergyTermGJE(const unsigned i, const double mean, const double sigma,
+                          const double scale, const double offset) const;
+  double getEnergy(const std::vector<double> &mean, const std::vector<double> &sigma,
+                   const double scale, const double offset);
+  double getEnergyChunk(const std::vector<double> &mean, const std::vector<unsigned> &indices,
+                        const unsigned first, const unsigned last) const;
   void setMetaDer(const unsigned index, const double der);
   void getEnergyForceSP(const std::vector<double> &mean, const std::vector<double> &dmean_x, const std::vector<double> &dmean_b);
   void getEnergyForceSPE(const std::vector<double> &mean, const std::vector<double> &dmean_x, const std::vector<double> &dmean_b);
@@ -169,12 +213,25 @@ private:
   void getEnergyForceMIGEN(const std::vector<double> &mean, const std::vector<double> &dmean_x, const std::vector<double> &dmean_b);
   double getCalcData(const unsigned index);
   void get_weights(double &weight, double &norm, double &neff);
-  void replica_averaging(const double weight, const double norm, std::vector<double> &mean, std::vector<double> &dmean_b);
-  void get_sigma_mean(const double weight, const double norm, const double neff, const std::vector<double> &mean);
+  void replica_averaging(const double weight, const double norm, std::vector<double> &mean);
+  template<typename T>
+  bool replica_averaging_packed(std::vector<T> &buffer, double &weight, double &norm, double &neff,
+                                std::vector<double> &mean, std::vector<double> &sigma_mean2_now);
+  void get_sigma_mean(const double weight, const double norm, const double neff, const std::vector<double> &mean,
+                      std::vector<double> &sigma_mean2_now);
   void do_regression_zero(const std::vector<double> &mean);
   void moveTilde(const std::vector<double> &mean_, double &old_energy);
   void moveScaleOffset(const std::vector<double> &mean_, double &old_energy);
   void moveSigmas(const std::vector<double> &mean_, double &old_energy, const unsigned i, const std::vector<unsigned> &indices, bool &breaknow);
+  double proposeSigmaChunk(const std::vector<double> &mean_, const std::vector<unsigned> &indices,
+                           const unsigned first, const unsigned last, const double *r, std::vector<double> &old_sigma);
+  void rejectSigmaChunk(const std::vector<unsigned> &indices, const unsigned first, const unsigned last,
+                        const std::vector<double> &old_sigma);
+  void moveSigmaChunks(const std::vector<double> &mean_, double &old_energy, const std::vector<unsigned> &indices);
+  void runMonteCarlo(const std::vector<double> &mean_, double &old_energy);
+  void setMonteCarloValues();
+  void startMonteCarlo(const std::vector<double> &mean_);
+  void waitMonteCarlo();
   double doMonteCarlo(const std::vector<double> &mean);
 
 public:
@@ -207,6 +264,65 @@ public:
   void setBoxDerivatives(Value*v, const Tensor&d);
 };
 
+inline
+double MetainferenceBase::getEnergyTermMIGEN(const unsigned i, const double mean, const double ftilde, const double sigma,
+    const double scale, const double offset) const
+{
+  const double inv_sb2  = 1./(sigma*sigma);
+  const double inv_sm2  = 1./sigma_mean2_[i];
+  double devb = 0;
+  if(gen_likelihood_==LIKE_GAUSS)     devb = scale*ftilde-parameters[i]+offset;
+  else if(gen_likelihood_==LIKE_LOGN) devb = std::log(scale*ftilde/parameters[i]);
+  double devm = mean - ftilde;
+  // deviation + normalisation + jeffrey
+  double normb = 0.;
+  if(gen_likelihood_==LIKE_GAUSS)     normb = -0.5*std::log(0.5/M_PI*inv_sb2);
+  else if(gen_likelihood_==LIKE_LOGN) normb = -0.5*std::log(0.5/M_PI*inv_sb2/(parameters[i]*parameters[i]));
+  const double normm         = -0.5*std::log(0.5/M_PI*inv_sm2);
+  const double jeffreys      = -0.5*std::log(2.*inv_sb2);
+  double ene = 0.5*devb*devb*inv_sb2 + 0.5*devm*devm*inv_sm2 + normb + normm + jeffreys;
+  if(doscale_ || doregres_zero_)  ene += jeffreys;
+  if(dooffset_) ene += jeffreys;
+  return ene;
+}
+
+inline
+double MetainferenceBase::getEnergyTermSPE(const unsigned i, const double mean, const double sigma,
+    const double scale, const double offset) const
+{
+  const double sm2 = sigma_mean2_[i];
+  const double ss2 = sigma*sigma + scale*scale*sm2;
+  const double sss = sigma*sigma + sm2;
+  const double dev = scale*mean-parameters[i]+offset;
+  const double a2  = 0.5*dev*dev + ss2;
+  double ene;
+  if(sm2 > 0.0) {
+    ene = 0.5*std::log(sss) + 0.5*std::log(0.5*M_PI*M_PI/ss2) + std::log(2.0*a2/(1.0-std::exp(-a2/sm2)));
+  }
+  else {
+    ene = 0.5*std::log(sss) + 0.5*std::log(0.5*M_PI*M_PI/ss2) + std::log(2.0*a2);
+  }
+  if(doscale_ || doregres_zero_)  ene += 0.5*std::log(sss);
+  if(dooffset_) ene += 0.5*std::log(sss);
+  return ene;
+}
+
+inline
+double MetainferenceBase::getEnergyTermGJE(const unsigned i, const double mean, const double sigma,
+    const double scale, const double offset) const
+{
+  const double inv_s2  = 1./(sigma*sigma + scale*scale*sigma_mean2_[i]);
+  const double inv_sss = 1./(sigma*sigma + sigma_mean2_[i]);
+  double dev = scale*mean-parameters[i]+offset;
+  // deviation + normalisation + jeffrey
+  const double normalisation = -0.5*std::log(0.5/M_PI*inv_s2);
+  const double jeffreys      = -0.5*std::log(2.*inv_sss);
+  double ene = 0.5*dev*dev*inv_s2 + normalisation + jeffreys;
+  if(doscale_ || doregres_zero_)  ene += jeffreys;
+  if(dooffset_) ene += jeffreys;
+  return ene;
+}
+
 inline
 void MetainferenceBase::setNarg(const unsigned input)
 {
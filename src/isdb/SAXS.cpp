@@ -34,6 +34,7 @@
 #include "tools/Communicator.h"
 #include "tools/Pbc.h"
 
+#include <algorithm>
 #include <map>
 #include <iterator>
 #include <iostream>
@@ -82,6 +83,11 @@ the SOLVDENS keyword.
 Experimental reference intensities can be added using the EXPINT keywords.
 By default SAXS is calculated using Debye on CPU, by adding the GPU flag it is possible to solve the equation on a
 GPU if the ARRAYFIRE libraries are installed and correctly linked.
+On CPUs, HISTOGRAM_BIN can be used to calculate the intensities from histograms of the distances between all pairs
+of beads with the same form factors (e.g. the same atom type), with bins of the given width. The cost of the sum over
+the q values then depends on the number of bins instead of on the number of pairs. A correction that is linear in the
+distance from the center of each bin is included, so that the error is of second order in the bin width.
+Derivatives are still calculated for each pair, without histograms.
 \ref METAINFERENCE can be activated using DOSCORE and the other relevant keywords.
 
 \par Examples
@@ -169,8 +175,22 @@ private:
   std::vector<double> Iq0_mix;
   double Iq0;
 
+  // width of the bins of the histograms of distances (zero if histograms are not used)
+  double hist_bin;
+  // beads with the same form factors are in the same class, with a representative bead for each class
+  std::vector<unsigned> ff_class;
+  std::vector<unsigned> ff_class_rep;
+  // if the q values are equally spaced, sin(qr) and cos(qr) are calculated by recurrence
+  bool q_equispaced;
+  double q_step;
+
   void calculate_gpu(std::vector<Vector> &pos, std::vector<Vector> &deriv);
   void calculate_cpu(std::vector<Vector> &pos, std::vector<Vector> &deriv);
+  void calculate_histogram(std::vector<Vector> &pos, std::vector<Vector> &deriv);
+  void calculate_histogram_score_derivatives(std::vector<Vector> &pos, std::vector<Vector> &deriv);
+  void setupFormFactorClasses();
+  void getSinCos(const double r, double* sinq, double* cosq) const;
+  void setBeadsDerivatives(Value* val, const std::vector<Vector> &aa_deriv, const Vector* bd_deriv, const double factor);
   void getMartiniSFparam(const std::vector<AtomNumber> &atoms, std::vector<std::vector<long double> > &parameter);
   void getOnebeadparam(const std::vector<AtomNumber> &atoms, std::vector<std::vector<long double> > &parameter_vac, std::vector<std::vector<long double> > &parameter_mix, std::vector<std::vector<long double> > &parameter_solv);
   void getOnebeadMapping(const std::vector<AtomNumber> &atoms);
@@ -196,6 +216,7 @@ void SAXS::registerKeywords(Keywords& keys) {
   keys.addFlag("SERIAL",false,"Perform the calculation in serial - for debug purpose");
   keys.add("compulsory","DEVICEID","-1","Identifier of the GPU to be used");
   keys.addFlag("GPU",false,"calculate SAXS using ARRAYFIRE on an accelerator device");
+  keys.add("optional","HISTOGRAM_BIN","calculate the intensities on the CPU from histograms of the distances between beads with the same form factors, using bins of this width (in nm)");
   keys.addFlag("ATOMISTIC",false,"calculate SAXS for an atomistic model");
   keys.addFlag("MARTINI",false,"calculate SAXS for a Martini model");
   keys.addFlag("ONEBEAD",false,"calculate SAXS for a single bead model");
@@ -218,7 +239,10 @@ SAXS::SAXS(const ActionOptions&ao):
   gpu(false),
   onebead(false),
   isFirstStep(true),
-  deviceid(-1)
+  deviceid(-1),
+  hist_bin(0.),
+  q_equispaced(false),
+  q_step(0.)
 {
   std::vector<AtomNumber> atoms;
   parseAtomList("ATOMS",atoms);
@@ -237,6 +261,11 @@ SAXS::SAXS(const ActionOptions&ao):
   if(gpu) error("To use the GPU mode PLUMED must be compiled with ARRAYFIRE");
 #endif
 
+  parse("HISTOGRAM_BIN",hist_bin);
+  if(hist_bin<0.) error("HISTOGRAM_BIN cannot be negative");
+  if(hist_bin>0.&&gpu) error("HISTOGRAM_BIN cannot be used with GPU");
+  if(hist_bin>0.) log.printf("  intensities calculated from histograms of distances with bins of %lf nm\n",hist_bin);
+
   parse("DEVICEID",deviceid);
 #ifdef  __PLUMED_HAS_ARRAYFIRE
   if(gpu&&comm.Get_rank()==0) {
@@ -485,6 +514,17 @@ SAXS::SAXS(const ActionOptions&ao):
   for(unsigned i=0; i<numq; ++i) {
     q_list[i]=q_list[i]*10.0;    //factor 10 to convert from A^-1 to nm^-1
   }
+  if(hist_bin>0.) {
+    if(numq>2) {
+      q_equispaced=true;
+      q_step=(q_list[numq-1]-q_list[0])/(numq-1);
+      for(unsigned i=1; i<numq; ++i) {
+        if(std::fabs(q_list[i]-q_list[0]-i*q_step)>1.e-10*q_list[numq-1]) q_equispaced=false;
+      }
+    }
+    if(q_equispaced) log.printf("  q values are equally spaced, sin(qr) and cos(qr) are calculated by recurrence\n");
+    if(!onebead) setupFormFactorClasses();
+  }
   log<<"  Bibliography ";
   if(martini) {
     log<<plumed.cite("Niebling, Björling, Westenhoff, J Appl Crystallogr 47, 1190–1198 (2014).");
@@ -759,6 +799,262 @@ void SAXS::calculate_cpu(std::vector<Vector> &pos, std::vector<Vector> &deriv)
   }
 }
 
+void SAXS::setupFormFactorClasses()
+{
+  // beads with the same form factors at all q values share the same histograms
+  std::map<std::vector<double>, unsigned> classes;
+  ff_class.resize(FF_value.size());
+  ff_class_rep.clear();
+  for(unsigned i=0; i<FF_value.size(); ++i) {
+    auto it = classes.find(FF_value[i]);
+    if(it==classes.end()) {
+      it = classes.insert(std::make_pair(FF_value[i], static_cast<unsigned>(ff_class_rep.size()))).first;
+      ff_class_rep.push_back(i);
+    }
+    ff_class[i] = it->second;
+  }
+}
+
+inline void SAXS::getSinCos(const double r, double* sinq, double* cosq) const
+{
+  const unsigned numq = q_list.size();
+  if(q_equispaced) {
+    // angle addition formulas, only two calls to sin and cos for all the q values
+    const double sd = std::sin(q_step*r);
+    const double cd = std::cos(q_step*r);
+    sinq[0] = std::sin(q_list[0]*r);
+    cosq[0] = std::cos(q_list[0]*r);
+    for(unsigned k=1; k<numq; ++k) {
+      sinq[k] = sinq[k-1]*cd + cosq[k-1]*sd;
+      cosq[k] = cosq[k-1]*cd - sinq[k-1]*sd;
+    }
+  } else {
+    for(unsigned k=0; k<numq; ++k) {
+      sinq[k] = std::sin(q_list[k]*r);
+      cosq[k] = std::cos(q_list[k]*r);
+    }
+  }
+}
+
+void SAXS::calculate_histogram(std::vector<Vector> &pos, std::vector<Vector> &deriv)
+{
+  const unsigned size = pos.size();
+  const unsigned numq = q_list.size();
+  const unsigned nclasses = ff_class_rep.size();
+
+  unsigned stride = comm.Get_size();
+  unsigned rank   = comm.Get_rank();
+  if(serial) {
+    stride = 1;
+    rank   = 0;
+  }
+
+  // index of the histogram of each pair of classes
+  unsigned npairs = 0;
+  std::vector<unsigned> pair_index(nclasses*nclasses);
+  for(unsigned a=0; a<nclasses; ++a) {
+    for(unsigned b=a; b<nclasses; ++b) {
+      pair_index[a*nclasses+b] = pair_index[b*nclasses+a] = npairs;
+      npairs++;
+    }
+  }
+
+  // distances are bounded by the diagonal of the box that contains all the beads
+  Vector pmin = pos[0];
+  Vector pmax = pos[0];
+  for(unsigned i=1; i<size; ++i) {
+    for(unsigned d=0; d<3; ++d) {
+      pmin[d] = std::min(pmin[d],pos[i][d]);
+      pmax[d] = std::max(pmax[d],pos[i][d]);
+    }
+  }
+  const double inv_bin = 1./hist_bin;
+  const unsigned nbins = static_cast<unsigned>(delta(pmin,pmax).modulo()*inv_bin)+2;
+
+  // for each pair of classes and bin: the number of pairs of beads and the sum of their
+  // distances from the center of the bin, used for the first order correction below
+  std::vector<double> hist(2*npairs*nbins,0.);
+  unsigned nt=OpenMP::getNumThreads();
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<double> omp_hist;
+    if(nt>1) omp_hist.assign(hist.size(),0.);
+    double* h = (nt>1) ? omp_hist.data() : hist.data();
+    #pragma omp for nowait
+    for (unsigned i=rank; i<size-1; i+=stride) {
+      const Vector posi = pos[i];
+      const unsigned* pidx = &pair_index[ff_class[i]*nclasses];
+      for (unsigned j=i+1; j<size ; ++j) {
+        const double m_distances = delta(posi,pos[j]).modulo();
+        const unsigned b = static_cast<unsigned>(m_distances*inv_bin+0.5);
+        const unsigned hdx = 2*(pidx[ff_class[j]]*nbins+b);
+        h[hdx]   += 1.;
+        h[hdx+1] += m_distances-b*hist_bin;
+      }
+    }
+    #pragma omp critical
+    if(nt>1) {
+      for(unsigned i=0; i<hist.size(); ++i) hist[i]+=omp_hist[i];
+    }
+  }
+
+  if(!serial) comm.Sum(hist);
+
+  // Debye sum over the bins, sinc(qr) and its derivative are calculated at the center of each bin
+  std::vector<double> hsum(npairs*numq,0.);
+  std::vector<double> sinq(numq), cosq(numq);
+  for(unsigned p=0; p<npairs; ++p) {
+    for(unsigned k=0; k<numq; ++k) hsum[p*numq+k] += hist[2*p*nbins];
+  }
+  for(unsigned b=1; b<nbins; ++b) {
+    bool empty=true;
+    for(unsigned p=0; p<npairs; ++p) {
+      if(hist[2*(p*nbins+b)]>0.) {empty=false; break;}
+    }
+    if(empty) continue;
+    const double r = b*hist_bin;
+    const double inv_r = 1./r;
+    getSinCos(r, sinq.data(), cosq.data());
+    for(unsigned k=0; k<numq; ++k) sinq[k] /= q_list[k]*r;
+    for(unsigned p=0; p<npairs; ++p) {
+      const double count = hist[2*(p*nbins+b)];
+      if(count==0.) continue;
+      const double moment = hist[2*(p*nbins+b)+1]*inv_r;
+      double* hs = &hsum[p*numq];
+      #pragma omp simd
+      for(unsigned k=0; k<numq; ++k) hs[k] += count*sinq[k] + moment*(cosq[k]-sinq[k]);
+    }
+  }
+
+  std::vector<double> sum(FF_rank);
+  for(unsigned a=0; a<nclasses; ++a) {
+    const std::vector<double> &ffa = FF_value[ff_class_rep[a]];
+    for(unsigned b=a; b<nclasses; ++b) {
+      const std::vector<double> &ffb = FF_value[ff_class_rep[b]];
+      const double* hs = &hsum[pair_index[a*nclasses+b]*numq];
+      for(unsigned k=0; k<numq; ++k) sum[k] += 2.*ffa[k]*ffb[k]*hs[k];
+    }
+  }
+
+  for (unsigned k=0; k<numq; ++k) {
+    std::string num; Tools::convert(k,num);
+    Value* val=getPntrToComponent("q-"+num);
+    val->set(sum[k]);
+    if(getDoScore()) setCalcData(k, sum[k]);
+  }
+
+  // with DOSCORE the derivatives of the score are calculated later on
+  if(getDoScore() || doNotCalculateDerivatives()) return;
+
+  // derivatives of each intensity, calculated exactly for each pair
+  std::vector<double> sinq_tmp(numq), cosq_tmp(numq), tmp(numq);
+  if(nt==1) {
+    for (unsigned i=rank; i<size-1; i+=stride) {
+      const Vector posi = pos[i];
+      const double* ffi = FF_value[i].data();
+      for (unsigned j=i+1; j<size; ++j) {
+        Vector c_distances = delta(posi,pos[j]);
+        const double m_distances = c_distances.modulo();
+        c_distances = c_distances/m_distances/m_distances;
+        getSinCos(m_distances, sinq_tmp.data(), cosq_tmp.data());
+        const double* ffj = FF_value[j].data();
+        #pragma omp simd
+        for (unsigned k=0; k<numq; ++k) {
+          tmp[k] = 2.*ffi[k]*ffj[k]*(cosq_tmp[k]-sinq_tmp[k]/(q_list[k]*m_distances));
+        }
+        for (unsigned k=0; k<numq; ++k) {
+          const Vector dd = c_distances*tmp[k];
+          deriv[k*size+i] -= dd;
+          deriv[k*size+j] += dd;
+        }
+      }
+    }
+  } else {
+    // every bead sums the contributions of all the other ones, so that there is
+    // no need of a private copy of the derivatives for each thread
+    #pragma omp parallel num_threads(nt)
+    {
+      std::vector<double> sinq(numq), cosq(numq), tmp(numq);
+      std::vector<Vector> deriv_i(numq);
+      #pragma omp for
+      for (unsigned i=rank; i<size; i+=stride) {
+        const Vector posi = pos[i];
+        const double* ffi = FF_value[i].data();
+        for(unsigned k=0; k<numq; ++k) deriv_i[k].zero();
+        for (unsigned j=0; j<size; ++j) {
+          if(j==i) continue;
+          Vector c_distances = delta(posi,pos[j]);
+          const double m_distances = c_distances.modulo();
+          c_distances = c_distances/m_distances/m_distances;
+          getSinCos(m_distances, sinq.data(), cosq.data());
+          const double* ffj = FF_value[j].data();
+          #pragma omp simd
+          for (unsigned k=0; k<numq; ++k) {
+            tmp[k] = 2.*ffi[k]*ffj[k]*(cosq[k]-sinq[k]/(q_list[k]*m_distances));
+          }
+          for (unsigned k=0; k<numq; ++k) deriv_i[k] -= c_distances*tmp[k];
+        }
+        for(unsigned k=0; k<numq; ++k) deriv[k*size+i] = deriv_i[k];
+      }
+    }
+  }
+
+  if(!serial) comm.Sum(&deriv[0][0], 3*deriv.size());
+}
+
+void SAXS::calculate_histogram_score_derivatives(std::vector<Vector> &pos, std::vector<Vector> &deriv)
+{
+  const unsigned size = pos.size();
+  const unsigned numq = q_list.size();
+
+  unsigned stride = comm.Get_size();
+  unsigned rank   = comm.Get_rank();
+  if(serial) {
+    stride = 1;
+    rank   = 0;
+  }
+
+  // the derivatives of the intensities are summed weighted by the derivatives of the score,
+  // so that each thread only needs a private copy of the derivatives of the score
+  std::vector<double> metader(numq);
+  for(unsigned k=0; k<numq; ++k) metader[k] = 2.*getMetaDer(k);
+
+  unsigned nt=OpenMP::getNumThreads();
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<Vector> omp_deriv;
+    if(nt>1) omp_deriv.resize(size);
+    std::vector<Vector> &d = (nt>1) ? omp_deriv : deriv;
+    std::vector<double> sinq(numq), cosq(numq);
+    #pragma omp for nowait
+    for (unsigned i=rank; i<size-1; i+=stride) {
+      const Vector posi = pos[i];
+      const double* ffi = FF_value[i].data();
+      for (unsigned j=i+1; j<size ; ++j) {
+        Vector c_distances = delta(posi,pos[j]);
+        const double m_distances = c_distances.modulo();
+        c_distances = c_distances/m_distances/m_distances;
+        getSinCos(m_distances, sinq.data(), cosq.data());
+        const double* ffj = FF_value[j].data();
+        double tmp = 0.;
+        #pragma omp simd reduction(+:tmp)
+        for (unsigned k=0; k<numq; ++k) {
+          tmp += metader[k]*ffi[k]*ffj[k]*(cosq[k]-sinq[k]/(q_list[k]*m_distances));
+        }
+        const Vector dd = c_distances*tmp;
+        d[i] -= dd;
+        d[j] += dd;
+      }
+    }
+    #pragma omp critical
+    if(nt>1) {
+      for(unsigned i=0; i<size; ++i) deriv[i]+=omp_deriv[i];
+    }
+  }
+
+  if(!serial) comm.Sum(&deriv[0][0], 3*deriv.size());
+}
+
 void SAXS::calculate()
 {
   if(pbc) makeWhole();
@@ -832,6 +1128,7 @@ void SAXS::calculate()
             FF_rank[k]+=FF_value[i][k]*FF_value[i][k];
           }
         }
+        if(hist_bin>0.) setupFormFactorClasses();
       }
     }
     // not ONEBEAD
@@ -843,6 +1140,7 @@ void SAXS::calculate()
   }
 
   if(gpu) calculate_gpu(beads_pos, bd_deriv);
+  else if(hist_bin>0.) calculate_histogram(beads_pos, bd_deriv);
   else calculate_cpu(beads_pos, bd_deriv);
 
   if(getDoScore()) {
@@ -851,65 +1149,50 @@ void SAXS::calculate()
     setScore(score);
   }
 
+  if(getDoScore()&&hist_bin>0.) {
+    // the derivatives of the score are calculated directly, without those of each intensity
+    std::vector<Vector> score_deriv(beads_size);
+    if(!doNotCalculateDerivatives()) calculate_histogram_score_derivatives(beads_pos, score_deriv);
+    setBeadsDerivatives(getPntrToComponent("score"), aa_deriv, &score_deriv[0], 1.);
+    return;
+  }
+
   for (unsigned k=0; k<numq; ++k) {
     const unsigned kdx=k*beads_size;
-    Tensor deriv_box;
-    Value* val;
     if(!getDoScore()) {
       std::string num; Tools::convert(k,num);
-      val=getPntrToComponent("q-"+num);
-
-      if(onebead) {
-        unsigned atom_id=0;
-        for(unsigned i=0; i<beads_size; ++i) {
-          for(unsigned j=0; j<atoms_per_bead[i]; ++j) {
-            setAtomsDerivatives(val, atom_id, Vector(aa_deriv[atom_id][0]*bd_deriv[kdx+i][0], \
-                                aa_deriv[atom_id][1]*bd_deriv[kdx+i][1], \
-                                aa_deriv[atom_id][2]*bd_deriv[kdx+i][2]) );
-            deriv_box += Tensor(getPosition(atom_id),Vector(aa_deriv[atom_id][0]*bd_deriv[kdx+i][0], \
-                                aa_deriv[atom_id][1]*bd_deriv[kdx+i][1], \
-                                aa_deriv[atom_id][2]*bd_deriv[kdx+i][2]) );
-            atom_id++;
-          }
-        }
-      } else {
-        for(unsigned i=0; i<beads_size; ++i) {
-          setAtomsDerivatives(val, i, Vector(bd_deriv[kdx+i][0], \
-                                             bd_deriv[kdx+i][1], \
-                                             bd_deriv[kdx+i][2]) );
-          deriv_box += Tensor(getPosition(i),Vector(bd_deriv[kdx+i][0], \
-                              bd_deriv[kdx+i][1], \
-                              bd_deriv[kdx+i][2]) );
-        }
-      }
+      setBeadsDerivatives(getPntrToComponent("q-"+num), aa_deriv, &bd_deriv[kdx], 1.);
     } else {
-      val=getPntrToComponent("score");
-      if(onebead) {
-        unsigned atom_id=0;
-        for(unsigned i=0; i<beads_size; ++i) {
-          for(unsigned j=0; j<atoms_per_bead[i]; ++j) {
-            setAtomsDerivatives(val, atom_id, Vector(aa_deriv[atom_id][0]*bd_deriv[kdx+i][0]*getMetaDer(k),
-                                aa_deriv[atom_id][1]*bd_deriv[kdx+i][1]*getMetaDer(k),
-                                aa_deriv[atom_id][2]*bd_deriv[kdx+i][2]*getMetaDer(k)) );
-            deriv_box += Tensor(getPosition(atom_id),Vector(aa_deriv[atom_id][0]*bd_deriv[kdx+i][0]*getMetaDer(k),
-                                aa_deriv[atom_id][1]*bd_deriv[kdx+i][1]*getMetaDer(k),
-                                aa_deriv[atom_id][2]*bd_deriv[kdx+i][2]*getMetaDer(k)) );
-            atom_id++;
-          }
-        }
-      } else {
-        for(unsigned i=0; i<beads_size; ++i) {
-          setAtomsDerivatives(val, i, Vector(bd_deriv[kdx+i][0]*getMetaDer(k),
-                                             bd_deriv[kdx+i][1]*getMetaDer(k),
-                                             bd_deriv[kdx+i][2]*getMetaDer(k)) );
-          deriv_box += Tensor(getPosition(i),Vector(bd_deriv[kdx+i][0]*getMetaDer(k),
-                              bd_deriv[kdx+i][1]*getMetaDer(k),
-                              bd_deriv[kdx+i][2]*getMetaDer(k)) );
-        }
+      setBeadsDerivatives(getPntrToComponent("score"), aa_deriv, &bd_deriv[kdx], getMetaDer(k));
+    }
+  }
+}
+
+void SAXS::setBeadsDerivatives(Value* val, const std::vector<Vector> &aa_deriv, const Vector* bd_deriv, const double factor)
+{
+  Tensor deriv_box;
+  if(onebead) {
+    unsigned atom_id=0;
+    for(unsigned i=0; i<nres; ++i) {
+      for(unsigned j=0; j<atoms_per_bead[i]; ++j) {
+        const Vector dd(aa_deriv[atom_id][0]*bd_deriv[i][0]*factor,
+                        aa_deriv[atom_id][1]*bd_deriv[i][1]*factor,
+                        aa_deriv[atom_id][2]*bd_deriv[i][2]*factor);
+        setAtomsDerivatives(val, atom_id, dd);
+        deriv_box += Tensor(getPosition(atom_id),dd);
+        atom_id++;
       }
     }
-    setBoxDerivatives(val, -deriv_box);
+  } else {
+    for(unsigned i=0; i<getNumberOfAtoms(); ++i) {
+      const Vector dd(bd_deriv[i][0]*factor,
+                      bd_deriv[i][1]*factor,
+                      bd_deriv[i][2]*factor);
+      setAtomsDerivatives(val, i, dd);
+      deriv_box += Tensor(getPosition(i),dd);
+    }
   }
+  setBoxDerivatives(val, -deriv_box);
 }
 
 void SAXS::update() {
@@ -554,7 +554,10 @@ void MultiColvarBase::setupLinkCells() {
     }
 
     // Build the lists for the link cells
-    linkcells.buildCellLists( ltmp_pos, ltmp_ind, getPbc() );
+    linkcelllist=atoms.getLinkCellsCache().get( comm, linkcells.getCutoff(), ltmp_pos, ltmp_ind, getPbc() );
+  } else {
+    // No atom is active, so the link cells are empty
+    linkcelllist=atoms.getLinkCellsCache().get( comm, linkcells.getCutoff(), std::vector<Vector>(), std::vector<unsigned>(), getPbc() );
   }
 }
 
@@ -575,7 +578,7 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
     for(unsigned i=rank; i<ablocks[0].size(); i+=stride) {
       if( !isCurrentlyActive( ablocks[0][i] ) ) continue;
       unsigned natomsper=1; linked_atoms[0]=my_always_active;  // Note we always check atom 0 because it is simpler than changing LinkCells.cpp
-      linkcells.retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, natomsper, linked_atoms );
+      linkcelllist->retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, natomsper, linked_atoms );
       for(unsigned j=0; j<natomsper; ++j) {
         for(unsigned k=bookeeping(i,linked_atoms[j]).first; k<bookeeping(i,linked_atoms[j]).second; ++k) taskFlags[k]=1;
       }
@@ -611,7 +614,7 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
       }
     }
     // Build the list of the link cells
-    threecells.buildCellLists( lttmp_pos, lttmp_ind, getPbc() );
+    threecelllist=atoms.getLinkCellsCache().get( comm, threecells.getCutoff(), lttmp_pos, lttmp_ind, getPbc() );
 
     // Ensure we only do tasks where atoms are in appropriate link cells
     std::vector<unsigned> linked_atoms( 1+ablocks[1].size() );
@@ -619,14 +622,14 @@ void MultiColvarBase::setupNonUseSpeciesLinkCells( const unsigned& my_always_act
     for(unsigned i=rank; i<ablocks[0].size(); i+=stride) {
       if( !isCurrentlyActive( ablocks[0][i] ) ) continue;
       unsigned natomsper=1; linked_atoms[0]=my_always_active;  // Note we always check atom 0 because it is simpler than changing LinkCells.cpp
-      linkcells.retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, natomsper, linked_atoms );
+      linkcelllist->retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, natomsper, linked_atoms );
       if( allthirdblockintasks ) {
         for(unsigned j=0; j<natomsper; ++j) {
           for(unsigned k=bookeeping(i,linked_atoms[j]).first; k<bookeeping(i,linked_atoms[j]).second; ++k) taskFlags[k]=1;
         }
       } else {
         unsigned ntatomsper=1; tlinked_atoms[0]=lttmp_ind[0];
-        threecells.retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, ntatomsper, tlinked_atoms );
+        threecelllist->retrieveNeighboringAtoms( getPositionOfAtomForLinkCells( ablocks[0][i] ), requiredlinkcells, ntatomsper, tlinked_atoms );
         for(unsigned j=0; j<natomsper; ++j) {
           for(unsigned k=0; k<ntatomsper; ++k) taskFlags[bookeeping(i,linked_atoms[j]).first+tlinked_atoms[k]]=1;
         }
@@ -654,14 +657,14 @@ bool MultiColvarBase::setupCurrentAtomList( const unsigned& taskCode, AtomValueP
     myatoms.setNumberOfAtoms( 1 ); myatoms.setAtom( 0, taskCode ); return true;
   } else if( usespecies ) {
     std::vector<unsigned> task_atoms(1); task_atoms[0]=taskCode;
-    unsigned natomsper=myatoms.setupAtomsFromLinkCells( task_atoms, getPositionOfAtomForLinkCells( taskCode ), linkcells );
+    unsigned natomsper=myatoms.setupAtomsFromLinkCells( task_atoms, getPositionOfAtomForLinkCells( taskCode ), *linkcelllist );
     return natomsper>1;
   } else if( matsums ) {
     myatoms.setNumberOfAtoms( getNumberOfAtoms() );
     for(unsigned i=0; i<getNumberOfAtoms(); ++i) myatoms.setAtom( i, i );
   } else if( allthirdblockintasks ) {
     plumed_dbg_assert( ablocks.size()==3 ); std::vector<unsigned> atoms(2); decodeIndexToAtoms( taskCode, atoms );
-    myatoms.setupAtomsFromLinkCells( atoms, getPositionOfAtomForLinkCells( atoms[0] ), threecells );
+    myatoms.setupAtomsFromLinkCells( atoms, getPositionOfAtomForLinkCells( atoms[0] ), *threecelllist );
   } else if( nblock>0 ) {
     std::vector<unsigned> atoms( ablocks.size() );
     decodeIndexToAtoms( taskCode, atoms ); myatoms.setNumberOfAtoms( ablocks.size() );
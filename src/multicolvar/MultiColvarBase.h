@@ -30,6 +30,7 @@
 #include "vesselbase/ActionWithVessel.h"
 #include "CatomPack.h"
 #include <vector>
+#include <memory>
 
 namespace PLMD {
 namespace multicolvar {
@@ -62,6 +63,10 @@ private:
   LinkCells linkcells;
 /// Link cells for third block of atoms
   LinkCells threecells;
+/// The link cells built at this step, which might be shared with other actions
+  std::shared_ptr<const LinkCells> linkcelllist;
+/// The link cells for the third block of atoms built at this step
+  std::shared_ptr<const LinkCells> threecelllist;
 /// Number of atoms that are being used for central atom position
   unsigned ncentral;
 /// Bool vector telling us which atoms are required to calculate central atom position
@@ -696,6 +696,15 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
           plumed_massert(file_max==arg_max,"RESTART - mismatch between old and new ARG periodicity");
         }
       }
+      //after the first line, the kernels that follow are read in bulk, until a new header is found
+      const std::size_t blocksize=4096;
+      std::vector<std::string> names(1,"time");
+      for(unsigned i=0; i<ncv_; i++)
+        names.push_back(getPntrToArgument(i)->getName());
+      for(unsigned i=0; i<ncv_; i++)
+        names.push_back("sigma_"+getPntrToArgument(i)->getName());
+      names.push_back("height");
+      std::vector<std::vector<double>> columns;
       if(stateRestart)
       {
         double time;
@@ -711,12 +720,35 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
           ifile.scanField("height",height);
           ifile.scanField();
           kernels_.emplace_back(height,center,sigma);
+          while(const std::size_t nread=ifile.scanColumns(names,columns,blocksize))
+          {
+            for(std::size_t n=0; n<nread; n++)
+            {
+              for(unsigned i=0; i<ncv_; i++)
+              {
+                center[i]=columns[1+i][n];
+                sigma[i]=columns[1+ncv_+i][n];
+              }
+              kernels_.emplace_back(columns[1+2*ncv_][n],center,sigma);
+            }
+          }
         }
         log.printf("    a total of %lu kernels where read\n",kernels_.size());
       }
       else
       {
         ifile.allowIgnoredFields(); //this allows for multiple restart, but without checking for consistency between them!
+        names.push_back("logweight");
+        auto restartKernel=[&](const double height,const std::vector<double>& center,const std::vector<double>& sigma,const double logweight)
+        {
+          if(counter_==(1+walker_rank_) && adaptive_sigma_)
+            sigma0_=sigma;
+          addKernel(height,center,sigma);
+          const double weight=std::exp(logweight);
+          sum_weights_+=weight; //this sum is slightly inaccurate, because when printing some precision is lost
+          sum_weights2_+=weight*weight;
+          counter_++;
+        };
         double time;
         while(ifile.scanField("time",time))
         {
@@ -728,16 +760,22 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
             ifile.scanField(getPntrToArgument(i)->getName(),center[i]);
           for(unsigned i=0; i<ncv_; i++)
             ifile.scanField("sigma_"+getPntrToArgument(i)->getName(),sigma[i]);
-          if(counter_==(1+walker_rank_) && adaptive_sigma_)
-            sigma0_=sigma;
           ifile.scanField("height",height);
           ifile.scanField("logweight",logweight);
           ifile.scanField();
-          addKernel(height,center,sigma);
-          const double weight=std::exp(logweight);
-          sum_weights_+=weight; //this sum is slightly inaccurate, because when printing some precision is lost
-          sum_weights2_+=weight*weight;
-          counter_++;
+          restartKernel(height,center,sigma,logweight);
+          while(const std::size_t nread=ifile.scanColumns(names,columns,blocksize))
+          {
+            for(std::size_t n=0; n<nread; n++)
+            {
+              for(unsigned i=0; i<ncv_; i++)
+              {
+                center[i]=columns[1+i][n];
+                sigma[i]=columns[1+ncv_+i][n];
+              }
+              restartKernel(columns[1+2*ncv_][n],center,sigma,columns[2+2*ncv_][n]);
+            }
+          }
         }
         KDEnorm_=mode::explore?counter_:sum_weights_;
         if(!no_Zed_)
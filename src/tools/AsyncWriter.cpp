@@ -0,0 +1,108 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2012-2022 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "AsyncWriter.h"
+#include "Exception.h"
+#include <utility>
+
+#ifdef __PLUMED_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace PLMD {
+
+AsyncWriter::AsyncWriter(std::size_t maxQueuedBytes):
+  queuedBytes(0),
+  maxQueuedBytes(maxQueuedBytes),
+  busy(false),
+  stop(false),
+  thread(&AsyncWriter::run,this)
+{
+}
+
+AsyncWriter::~AsyncWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop=true;
+  }
+  taskAvailable.notify_one();
+// queued data are written before the thread terminates
+  thread.join();
+}
+
+void AsyncWriter::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while(true) {
+    taskAvailable.wait(lock,[this] { return stop || !queue.empty(); });
+    if(queue.empty()) return;
+    Task task(std::move(queue.front()));
+    queue.pop_front();
+    busy=true;
+    lock.unlock();
+    std::string message;
+    if(task.flush) {
+      if(task.fp) std::fflush(task.fp);
+#ifdef __PLUMED_HAS_ZLIB
+      if(task.gzfp) gzflush(gzFile(task.gzfp),Z_FULL_FLUSH);
+#endif
+    } else if(task.gzfp) {
+#ifdef __PLUMED_HAS_ZLIB
+      if(gzwrite(gzFile(task.gzfp),task.data.data(),task.data.length())!=int(task.data.length())) message="error writing file "+task.path;
+#endif
+    } else if(std::fwrite(task.data.data(),1,task.data.length(),task.fp)!=task.data.length()) {
+      message="error writing file "+task.path;
+    }
+    lock.lock();
+    if(error.empty()) error=message;
+    queuedBytes-=task.data.length();
+    busy=false;
+    taskDone.notify_all();
+  }
+}
+
+void AsyncWriter::write(FILE* fp,void* gzfp,const std::string & path,std::string && data) {
+  std::unique_lock<std::mutex> lock(mtx);
+// bound the amount of data waiting to be written
+  taskDone.wait(lock,[this] { return queue.empty() || queuedBytes<maxQueuedBytes; });
+  queuedBytes+=data.length();
+  queue.push_back(Task{fp,gzfp,path,std::move(data),false});
+  lock.unlock();
+  taskAvailable.notify_one();
+}
+
+void AsyncWriter::flush(FILE* fp,void* gzfp,const std::string & path) {
+  std::unique_lock<std::mutex> lock(mtx);
+  queue.push_back(Task{fp,gzfp,path,std::string(),true});
+  lock.unlock();
+  taskAvailable.notify_one();
+}
+
+void AsyncWriter::wait() {
+  std::unique_lock<std::mutex> lock(mtx);
+  taskDone.wait(lock,[this] { return queue.empty() && !busy; });
+  if(!error.empty()) {
+    std::string message;
+    std::swap(message,error);
+    plumed_merror(message);
+  }
+}
+
+}
@@ -0,0 +1,93 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2012-2022 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_AsyncWriter_h
+#define __PLUMED_tools_AsyncWriter_h
+
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+Class writing files on a background thread.
+
+Data already formatted by OFile are queued together with the file they should be written to,
+and are written by a separate thread in the same order in which they were queued.
+In this manner, a slow file system does not delay the thread running the simulation.
+The amount of queued data is bounded: when the limit is reached, write() waits until
+the background thread has caught up.
+
+Files should not be closed or reopened while operations on them are still queued.
+For this reason, OFile calls wait() before doing so.
+Errors found by the background thread are reported by the next call to wait().
+*/
+class AsyncWriter {
+/// A single operation on a file
+  struct Task {
+    FILE* fp;
+    void* gzfp;
+    std::string path;
+    std::string data;
+    bool flush;
+  };
+/// Operations waiting to be performed
+  std::deque<Task> queue;
+/// Total number of bytes in queue
+  std::size_t queuedBytes;
+/// Maximum number of bytes in queue
+  std::size_t maxQueuedBytes;
+/// True while the background thread is performing an operation
+  bool busy;
+/// Set to true to terminate the background thread
+  bool stop;
+/// Error found by the background thread
+  std::string error;
+  std::mutex mtx;
+/// Used to wake up the background thread
+  std::condition_variable taskAvailable;
+/// Used to wake up threads waiting for the queue to be processed
+  std::condition_variable taskDone;
+  std::thread thread;
+/// Loop executed by the background thread
+  void run();
+public:
+/// Constructor, starting the background thread
+  explicit AsyncWriter(std::size_t maxQueuedBytes);
+/// Destructor, writing all the queued data and terminating the background thread
+  ~AsyncWriter();
+/// Queue data to be written on a file
+  void write(FILE* fp,void* gzfp,const std::string & path,std::string && data);
+/// Queue a flush of a file
+  void flush(FILE* fp,void* gzfp,const std::string & path);
+/// Wait until all the queued operations have been performed
+  void wait();
+};
+
+}
+
+#endif
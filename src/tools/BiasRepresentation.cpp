@@ -26,6 +26,7 @@
 #include "KernelFunctions.h"
 #include "File.h"
 #include "Grid.h"
+#include <algorithm>
 
 namespace PLMD {
 
@@ -158,7 +159,6 @@ void BiasRepresentation::pushKernel( IFile *ifile ) {
     ifile->scanField("biasf",dummy);
     Tools::convert(dummy,dummyd);
   } else {dummyd=1.0;}
-  biasf.push_back(dummyd);
   // the domain does not pertain to the kernel but to the values here defined
   std::string mins,maxs,minv,maxv,mini,maxi; mins="min_"; maxs="max_";
   for(int i=0 ; i<ndim; i++) {
@@ -171,6 +171,30 @@ void BiasRepresentation::pushKernel( IFile *ifile ) {
       plumed_massert(maxi==maxv,"the input periodicity in hills and in value definition does not match"  );
     }
   }
+  addKernel(std::move(kk),dummyd);
+}
+
+std::size_t BiasRepresentation::pushKernels( IFile *ifile, std::size_t maxkernels ) {
+  plumed_massert(hasSigmaInInput(),"only histogram points can be read in bulk");
+  // header and periodicity have been already checked with pushKernel
+  std::vector<std::string> columnNames(names);
+  std::vector<std::string> fields;
+  ifile->getColumnList(fields);
+  const bool hasbiasf=(std::find(fields.begin(),fields.end(),"biasf")!=fields.end());
+  if(hasbiasf) columnNames.push_back("biasf");
+  std::vector<std::vector<double>> columns;
+  std::size_t nread=ifile->scanColumns(columnNames,columns,maxkernels);
+  std::vector<double> cc(ndim);
+  for(std::size_t n=0; n<nread; n++) {
+    for(int i=0; i<ndim; i++) cc[i]=columns[i][n];
+    double h=1.0;
+    addKernel(Tools::make_unique<KernelFunctions>(cc,histosigma,"stretched-gaussian","DIAGONAL",h),hasbiasf?columns[ndim][n]:1.0);
+  }
+  return nread;
+}
+
+void BiasRepresentation::addKernel(std::unique_ptr<KernelFunctions> kk, double kbiasf) {
+  biasf.push_back(kbiasf);
   // if grid is defined then it should be added on the grid
   //cerr<<"now with "<<hills.size()<<endl;
   if(hasgrid) {
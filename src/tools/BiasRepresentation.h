@@ -25,6 +25,7 @@
 #include "Exception.h"
 #include <memory>
 #include <vector>
+#include <cstddef>
 
 namespace PLMD {
 
@@ -61,6 +62,9 @@ public:
   void 		addGrid(const std::vector<std::string> & gmin, const std::vector<std::string> & gmax, const std::vector<unsigned> & nbin );
   /// push a kernel on the representation (includes widths and height)
   void 		pushKernel( IFile * ff);
+  /// push at most maxkernels histogram points, reading in bulk the lines following the last one read.
+  /// returns the number of points read (see IFile::scanColumns())
+  std::size_t 	pushKernels( IFile * ff, std::size_t maxkernels);
   /// set the flag that rescales the free energy to the bias
   void 		setRescaledToBias(bool rescaled);
   /// check if the representation is rescaled to the bias
@@ -86,6 +90,8 @@ public:
   /// clear the representation (grid included)
   void clear();
 private:
+  /// add a kernel to the representation
+  void addKernel(std::unique_ptr<KernelFunctions> kk, double kbiasf);
   int ndim;
   bool hasgrid;
   bool rescaledToBias;
@@ -131,6 +131,24 @@ void Communicator::Sum(Data data) {
 #endif
 }
 
+Communicator::Request Communicator::Isum(Data data) {
+  Request req;
+#if defined(__PLUMED_HAS_MPI)
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+#if MPI_VERSION >= 3
+  MPI_Iallreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_SUM,communicator,&req.r);
+#else
+// non-blocking collectives are not available, communication is completed here
+  MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_SUM,communicator);
+  req.r=MPI_REQUEST_NULL;
+#endif
+#else
+  (void) data;
+  plumed_merror("you are trying to use an MPI function, but PLUMED has been compiled without MPI support");
+#endif
+  return req;
+}
+
 void Communicator::Prod(Data data) {
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_PROD,communicator);
@@ -197,6 +215,54 @@ void Communicator::Allgatherv(ConstData in,Data out,const int*recvcounts,const i
 #endif
 }
 
+Communicator::Request Communicator::Iallgatherv(ConstData in,Data out,const int*recvcounts,const int*displs) {
+  Request req;
+  void*s=const_cast<void*>((const void*)in.pointer);
+  void*r=const_cast<void*>((const void*)out.pointer);
+  int*rc=const_cast<int*>(recvcounts);
+  int*di=const_cast<int*>(displs);
+#if defined(__PLUMED_HAS_MPI)
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+  if(s==NULL)s=MPI_IN_PLACE;
+#if MPI_VERSION >= 3
+  MPI_Iallgatherv(s,in.size,in.type,r,rc,di,out.type,communicator,&req.r);
+#else
+// non-blocking collectives are not available, communication is completed here
+  MPI_Allgatherv(s,in.size,in.type,r,rc,di,out.type,communicator);
+  req.r=MPI_REQUEST_NULL;
+#endif
+#else
+  (void) s;
+  (void) r;
+  (void) rc;
+  (void) di;
+  plumed_merror("you are trying to use an MPI function, but PLUMED has been compiled without MPI support");
+#endif
+  return req;
+}
+
+Communicator::Request Communicator::Iallgather(ConstData in,Data out) {
+  Request req;
+  void*s=const_cast<void*>((const void*)in.pointer);
+  void*r=const_cast<void*>((const void*)out.pointer);
+#if defined(__PLUMED_HAS_MPI)
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+  if(s==NULL)s=MPI_IN_PLACE;
+#if MPI_VERSION >= 3
+  MPI_Iallgather(s,in.size,in.type,r,out.size/Get_size(),out.type,communicator,&req.r);
+#else
+// non-blocking collectives are not available, communication is completed here
+  MPI_Allgather(s,in.size,in.type,r,out.size/Get_size(),out.type,communicator);
+  req.r=MPI_REQUEST_NULL;
+#endif
+#else
+  (void) s;
+  (void) r;
+  plumed_merror("you are trying to use an MPI function, but PLUMED has been compiled without MPI support");
+#endif
+  return req;
+}
+
 void Communicator::Allgather(ConstData in,Data out) {
   void*s=const_cast<void*>((const void*)in.pointer);
   void*r=const_cast<void*>((const void*)out.pointer);
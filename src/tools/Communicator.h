@@ -178,6 +178,15 @@ public:
   template <class T> void Sum(T*buf,int count) {Sum(Data(buf,count));}
 /// Wrapper for MPI_Allreduce with MPI_SUM (reference)
   template <class T> void Sum(T&buf) {Sum(Data(buf));}
+/// Wrapper for MPI_Iallreduce with MPI_SUM (data struct).
+/// The buffer should not be touched until the returned request is completed.
+/// If the MPI library does not support non-blocking collectives, the communication
+/// is completed immediately.
+  Request Isum(Data);
+/// Wrapper for MPI_Iallreduce with MPI_SUM (pointer)
+  template <class T> Request Isum(T*buf,int count) {return Isum(Data(buf,count));}
+/// Wrapper for MPI_Iallreduce with MPI_SUM (reference)
+  template <class T> Request Isum(T&buf) {return Isum(Data(buf));}
 /// Wrapper for MPI_Allreduce with MPI_PROD (data struct)
   void Prod(Data);
 /// Wrapper for MPI_Allreduce with MPI_PROD (pointer)
@@ -222,6 +231,26 @@ public:
     Allgatherv(ConstData(sendbuf),Data(recvbuf),recvcounts,displs);
   }
 
+/// Wrapper for MPI_Iallgatherv (data struct).
+/// Buffers, counts and displacements should not be touched until the returned request is completed.
+/// If the MPI library does not support non-blocking collectives, the communication
+/// is completed immediately.
+  Request Iallgatherv(ConstData in,Data out,const int*,const int*);
+/// Wrapper for MPI_Iallgatherv (pointer)
+  template <class T,class S> Request Iallgatherv(const T*sendbuf,int sendcount,S*recvbuf,const int*recvcounts,const int*displs) {
+    return Iallgatherv(ConstData(sendbuf,sendcount),Data(recvbuf,0),recvcounts,displs);
+  }
+
+/// Wrapper for MPI_Iallgather (data struct).
+/// Buffers should not be touched until the returned request is completed.
+/// If the MPI library does not support non-blocking collectives, the communication
+/// is completed immediately.
+  Request Iallgather(ConstData in,Data out);
+/// Wrapper for MPI_Iallgather (pointer)
+  template <class T,class S> Request Iallgather(const T*sendbuf,int sendcount,S*recvbuf,int recvcount) {
+    return Iallgather(ConstData(sendbuf,sendcount),Data(recvbuf,recvcount*Get_size()));
+  }
+
 /// Wrapper for MPI_Allgather (data struct)
   void Allgather(ConstData in,Data out);
 /// Wrapper for MPI_Allgatherv (pointer)
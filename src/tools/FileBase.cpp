@@ -39,6 +39,12 @@
 
 namespace PLMD {
 
+const char FileBase::binaryMagic[8]= {'\x89','P','L','U','M','E','D','\n'};
+
+const std::uint32_t FileBase::binaryVersion=1;
+
+const std::uint32_t FileBase::binaryByteOrder=0x01020304;
+
 FileBase& FileBase::link(FILE*fp) {
   plumed_massert(!this->fp,"cannot link an already open file");
   this->fp=fp;
@@ -114,6 +120,7 @@ FileBase::FileBase():
   eof(false),
   err(false),
   heavyFlush(false),
+  binary(false),
   enforcedSuffix_(false)
 {
 }
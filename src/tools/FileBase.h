@@ -23,6 +23,7 @@
 #define __PLUMED_tools_FileBase_h
 
 #include <string>
+#include <cstdint>
 
 namespace PLMD {
 
@@ -79,6 +80,16 @@ protected:
   std::string mode;
 /// Set to true if you want flush to be heavy (close/reopen)
   bool heavyFlush;
+/// Set to true if the file is in binary format.
+/// Binary files are written when the path has extension pbin and
+/// are recognized from their first bytes when read.
+  bool binary;
+/// Magic bytes at the beginning of each header of a binary file
+  static const char binaryMagic[8];
+/// Version of the binary format
+  static const std::uint32_t binaryVersion;
+/// Written in each header of a binary file to detect its byte order
+  static const std::uint32_t binaryByteOrder;
 public:
 /// Append suffix.
 /// It appends the desired suffix to the string. Notice that
@@ -107,13 +118,15 @@ public:
   virtual FileBase& flush();
 /// Closes the file
 /// Should be used only for explicitely opened files.
-  void        close();
+  virtual void close();
 /// Virtual destructor (allows inheritance)
   virtual ~FileBase();
 /// Check for error/eof.
   operator bool () const;
 /// Set heavyFlush flag
   void setHeavyFlush() { heavyFlush=true;}
+/// Check if the file is in binary format
+  bool isBinary()const { return binary;}
 /// Opens the file
   virtual FileBase& open(const std::string&name)=0;
 /// Check if the file exists
@@ -36,6 +36,8 @@
 #include <cstdio>
 #include <cfloat>
 #include <array>
+#include <algorithm>
+#include <cstdint>
 
 namespace PLMD {
 
@@ -113,9 +115,11 @@ void GridBase::Init(const std::string& funcl, const std::vector<std::string> &na
   usederiv_=usederiv;
   if(dospline_) plumed_assert(dospline_==usederiv_);
   maxsize_=1;
+  indexStride_.resize(dimension_);
   for(unsigned int i=0; i<dimension_; ++i) {
     dx_.push_back( (max_[i]-min_[i])/static_cast<double>( nbin_[i] ) );
     if( !pbc_[i] ) { max_[i] += dx_[i]; nbin_[i] += 1; }
+    indexStride_[i]=maxsize_;
     maxsize_*=nbin_[i];
   }
 }
@@ -162,11 +166,7 @@ unsigned GridBase::getDimension() const {
 GridBase::index_t GridBase::getIndex(const std::vector<unsigned> & indices) const {
   plumed_dbg_assert(indices.size()==dimension_);
   for(unsigned int i=0; i<dimension_; i++)
-    if(indices[i]>=nbin_[i]) {
-      std::string is;
-      Tools::convert(i,is);
-      plumed_error() << "Looking for a value outside the grid along the " << is << " dimension (arg name: "<<getArgNames()[i]<<")";
-    }
+    if(indices[i]>=nbin_[i]) outsideGrid(i);
   index_t index=indices[dimension_-1];
   for(unsigned int i=dimension_-1; i>0; --i) {
     index=index*nbin_[i-1]+indices[i-1];
@@ -174,6 +174,12 @@ GridBase::index_t GridBase::getIndex(const std::vector<unsigned> & indices) cons
   return index;
 }
 
+void GridBase::outsideGrid(unsigned i) const {
+  std::string is;
+  Tools::convert(i,is);
+  plumed_error() << "Looking for a value outside the grid along the " << is << " dimension (arg name: "<<getArgNames()[i]<<")";
+}
+
 GridBase::index_t GridBase::getIndex(const std::vector<double> & x) const {
   plumed_dbg_assert(x.size()==dimension_);
   return getIndex(getIndices(x));
@@ -396,6 +402,13 @@ double GridBase::getValue(const std::vector<double> & x) const {
   if(!dospline_) {
     return getValue(getIndex(x));
   } else {
+    std::array<double,4> dd;
+    switch(dimension_) {
+    case 1: return interpolate<1>(x.data(),dd.data());
+    case 2: return interpolate<2>(x.data(),dd.data());
+    case 3: return interpolate<3>(x.data(),dd.data());
+    case 4: return interpolate<4>(x.data(),dd.data());
+    }
     std::vector<double> der(dimension_);
     return getValueAndDerivatives(x,der);
   }
@@ -405,9 +418,85 @@ double GridBase::getValueAndDerivatives(const std::vector<unsigned> & indices, s
   return getValueAndDerivatives(getIndex(indices),der);
 }
 
+double GridBase::getValueAndDerivatives(index_t index, double* der) const {
+  std::vector<double> dder(dimension_);
+  double value=getValueAndDerivatives(index,dder);
+  for(unsigned i=0; i<dimension_; ++i) der[i]=dder[i];
+  return value;
+}
+
+// this is the same algorithm used below for an arbitrary number of dimensions.
+// operations are done in the same order, so that results are identical
+template<unsigned dim>
+double GridBase::interpolate(const double* x, double* der) const {
+  std::array<unsigned,dim> indices;
+  for(unsigned j=0; j<dim; ++j) {
+    indices[j]=unsigned(std::floor((x[j]-min_[j])/dx_[j]));
+    if(indices[j]>=nbin_[j]) outsideGrid(j);
+  }
+
+  if(!dospline_) {
+    index_t index=0;
+    for(unsigned j=0; j<dim; ++j) index+=indices[j]*indexStride_[j];
+    return getValueAndDerivatives(index,der);
+  }
+
+  std::array<double,dim> xfloor, dder, fd, C, D;
+  for(unsigned j=0; j<dim; ++j) xfloor[j]=min_[j]+(double)(indices[j])*dx_[j];
+  double value=0.0;
+  for(unsigned j=0; j<dim; ++j) der[j]=0.0;
+
+// loop over the 2^dim neighbors
+  for(unsigned ipoint=0; ipoint<(1u<<dim); ++ipoint) {
+    std::array<bool,dim> x0;
+    index_t index=0;
+    bool inside=true;
+    for(unsigned j=0; j<dim; ++j) {
+      unsigned i0=((ipoint>>j)&1)+indices[j];
+      if(i0==nbin_[j]) {
+        if(!pbc_[j]) {inside=false; break;}
+        i0=0;
+      }
+      x0[j]=(i0!=indices[j]);
+      index+=i0*indexStride_[j];
+    }
+    if(!inside) continue;
+
+    double grid=getValueAndDerivatives(index,dder.data());
+    double ff=1.0;
+    for(unsigned j=0; j<dim; ++j) {
+      const double dx=dx_[j];
+      const double X=std::abs((x[j]-xfloor[j])/dx-(double)x0[j]);
+      const double X2=X*X;
+      const double X3=X2*X;
+      double yy;
+      if(std::abs(grid)<0.0000001) yy=0.0;
+      else yy=-dder[j]/grid;
+      C[j]=(1.0-3.0*X2+2.0*X3) - (x0[j]?-1.0:1.0)*yy*(X-2.0*X2+X3)*dx;
+      D[j]=( -6.0*X +6.0*X2) - (x0[j]?-1.0:1.0)*yy*(1.0-4.0*X +3.0*X2)*dx;
+      D[j]*=(x0[j]?-1.0:1.0)/dx;
+      ff*=C[j];
+    }
+    for(unsigned j=0; j<dim; ++j) {
+      fd[j]=D[j];
+      for(unsigned i=0; i<dim; ++i) if(i!=j) fd[j]*=C[i];
+    }
+    value+=grid*ff;
+    for(unsigned j=0; j<dim; ++j) der[j]+=grid*fd[j];
+  }
+  return value;
+}
+
 double GridBase::getValueAndDerivatives(const std::vector<double> & x, std::vector<double>& der) const {
   plumed_dbg_assert(der.size()==dimension_ && usederiv_);
 
+  switch(dimension_) {
+  case 1: return interpolate<1>(x.data(),der.data());
+  case 2: return interpolate<2>(x.data(),der.data());
+  case 3: return interpolate<3>(x.data(),der.data());
+  case 4: return interpolate<4>(x.data(),der.data());
+  }
+
   if(dospline_) {
     double X,X2,X3,value;
     std::array<double,maxdim> fd, C, D;
@@ -535,8 +624,8 @@ void GridBase::writeCubeFile(OFile& ofile, const double& lunit) {
 
 std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile,
     const std::vector<std::string> & gmin,const std::vector<std::string> & gmax,
-    const std::vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder) {
-  std::unique_ptr<GridBase> grid=GridBase::create(funcl,args,ifile,dosparse,dospline,doder);
+    const std::vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder, bool dotiled) {
+  std::unique_ptr<GridBase> grid=GridBase::create(funcl,args,ifile,dosparse,dospline,doder,dotiled);
   std::vector<unsigned> cbin( grid->getNbin() );
   std::vector<std::string> cmin( grid->getMin() ), cmax( grid->getMax() );
   for(unsigned i=0; i<args.size(); ++i) {
@@ -551,7 +640,7 @@ std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::
   return grid;
 }
 
-std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder)
+std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder, bool dotiled)
 {
   std::unique_ptr<GridBase> grid;
   unsigned nvar=args.size(); bool hasder=false; std::string pstring;
@@ -588,7 +677,8 @@ std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::
   }
 
   if(!dosparse) {grid=Tools::make_unique<Grid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
-  else {grid=Tools::make_unique<SparseGrid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
+  else if(!dotiled) {grid=Tools::make_unique<SparseGrid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
+  else {grid=Tools::make_unique<TiledSparseGrid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
 
   std::vector<double> xx(nvar),dder(nvar);
   std::vector<double> dx=grid->getDx();
@@ -732,6 +822,12 @@ double Grid::getValueAndDerivatives(index_t index, std::vector<double>& der) con
   return grid_[index];
 }
 
+double Grid::getValueAndDerivatives(index_t index, double* der) const {
+  plumed_dbg_assert(index<maxsize_ && usederiv_);
+  for(unsigned i=0; i<dimension_; i++) der[i]=der_[dimension_*index+i];
+  return grid_[index];
+}
+
 void Grid::setValue(index_t index, double value) {
   plumed_dbg_assert(index<maxsize_ && !usederiv_);
   grid_[index]=value;
@@ -781,6 +877,17 @@ double SparseGrid::getValueAndDerivatives(index_t index, std::vector<double>& de
   return value;
 }
 
+double SparseGrid::getValueAndDerivatives(index_t index, double* der)const {
+  plumed_assert(index<maxsize_ && usederiv_);
+  double value=0.0;
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+  const auto it=map_.find(index);
+  if(it!=map_.end()) value=it->second;
+  const auto itder=der_.find(index);
+  if(itder!=der_.end()) for(unsigned int i=0; i<dimension_; ++i) der[i]=itder->second[i];
+  return value;
+}
+
 void SparseGrid::setValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
   map_[index]=value;
@@ -848,6 +955,225 @@ double SparseGrid::getMaxValue() const {
   return maxval;
 }
 
+constexpr TiledSparseGrid::index_t TiledSparseGrid::empty_;
+
+TiledSparseGrid::TiledSparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                                 const std::vector<std::string> & gmax,
+                                 const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
+  GridBase(funcl,args,gmin,gmax,nbin,dospline,usederiv),
+  tileSide_(dimension_),
+  ntiles_(dimension_),
+  tileSize_(1),
+  stride_(usederiv_?1+dimension_:1),
+  table_(64,std::pair<index_t,index_t>(empty_,0)),
+  tableBits_(6),
+  nstored_(0)
+{
+// tiles contain at most 64 bins, split evenly among dimensions
+  unsigned side=1;
+  while(true) {
+    unsigned p=1;
+    for(unsigned i=0; i<dimension_ && p<=64; i++) p*=side+1;
+    if(p>64) break;
+    side++;
+  }
+  for(unsigned i=0; i<dimension_; i++) {
+    tileSide_[i]=std::min(side,nbin_[i]);
+    ntiles_[i]=(nbin_[i]+tileSide_[i]-1)/tileSide_[i];
+    tileSize_*=tileSide_[i];
+  }
+}
+
+void TiledSparseGrid::getTile(index_t index, index_t & tile, unsigned & offset) const {
+  plumed_dbg_assert(index<maxsize_);
+  tile=0;
+  offset=0;
+  index_t ntile=1;
+  unsigned nside=1;
+  for(unsigned i=0; i<dimension_; i++) {
+    const unsigned k=index%nbin_[i];
+    index/=nbin_[i];
+    tile+=ntile*(k/tileSide_[i]);
+    offset+=nside*(k%tileSide_[i]);
+    ntile*=ntiles_[i];
+    nside*=tileSide_[i];
+  }
+}
+
+void TiledSparseGrid::getTileBins(index_t tile, std::vector<index_t> & bins) const {
+  bins.assign(tileSize_,0);
+  std::vector<unsigned> first(dimension_);
+  for(unsigned i=0; i<dimension_; i++) {
+    first[i]=(tile%ntiles_[i])*tileSide_[i];
+    tile/=ntiles_[i];
+  }
+  for(unsigned offset=0; offset<tileSize_; offset++) {
+    unsigned o=offset;
+    index_t index=0;
+    index_t n=1;
+    bool inside=true;
+    for(unsigned i=0; i<dimension_; i++) {
+      const unsigned k=first[i]+o%tileSide_[i];
+      o/=tileSide_[i];
+      if(k>=nbin_[i]) inside=false;
+      index+=n*k;
+      n*=nbin_[i];
+    }
+    bins[offset]=(inside?index:maxsize_);
+  }
+}
+
+TiledSparseGrid::index_t TiledSparseGrid::findSlot(index_t tile) const {
+// multiplicative hashing, table size is a power of two.
+// The high bits of the product are used, since the low ones only depend on the low bits of tile
+  const index_t mask=table_.size()-1;
+  index_t slot=static_cast<index_t>((static_cast<std::uint64_t>(tile)*11400714819323198485ull)>>(64-tableBits_));
+  while(table_[slot].first!=empty_ && table_[slot].first!=tile) slot=(slot+1)&mask;
+  return slot;
+}
+
+void TiledSparseGrid::rehash() {
+  table_.assign(2*table_.size(),std::pair<index_t,index_t>(empty_,0));
+  tableBits_++;
+  for(index_t i=0; i<tiles_.size(); i++) table_[findSlot(tiles_[i])]=std::pair<index_t,index_t>(tiles_[i],i);
+}
+
+const double* TiledSparseGrid::find(index_t index) const {
+  index_t tile;
+  unsigned offset;
+  getTile(index,tile,offset);
+  const auto & entry(table_[findSlot(tile)]);
+  if(entry.first==empty_) return nullptr;
+  return &data_[(entry.second*tileSize_+offset)*stride_];
+}
+
+double* TiledSparseGrid::findOrCreate(index_t index) {
+  index_t tile;
+  unsigned offset;
+  getTile(index,tile,offset);
+  index_t slot=findSlot(tile);
+  if(table_[slot].first==empty_) {
+// keep the load factor below 1/2
+    if(2*(tiles_.size()+1)>table_.size()) {
+      rehash();
+      slot=findSlot(tile);
+    }
+    table_[slot]=std::pair<index_t,index_t>(tile,tiles_.size());
+    tiles_.push_back(tile);
+    data_.resize(data_.size()+tileSize_*stride_,0.0);
+    std::vector<index_t> bins;
+    getTileBins(tile,bins);
+    for(const auto & b : bins) if(b<maxsize_) nstored_++;
+  }
+  return &data_[(table_[slot].second*tileSize_+offset)*stride_];
+}
+
+TiledSparseGrid::index_t TiledSparseGrid::getSize() const {
+  return nstored_;
+}
+
+TiledSparseGrid::index_t TiledSparseGrid::getMaxSize() const {
+  return maxsize_;
+}
+
+double TiledSparseGrid::getValue(index_t index)const {
+  plumed_assert(index<maxsize_);
+  const double* d=find(index);
+  return (d?d[0]:0.0);
+}
+
+double TiledSparseGrid::getValueAndDerivatives(index_t index, std::vector<double>& der)const {
+  plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  const double* d=find(index);
+  if(!d) {
+    for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+    return 0.0;
+  }
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=d[1+i];
+  return d[0];
+}
+
+double TiledSparseGrid::getValueAndDerivatives(index_t index, double* der)const {
+  plumed_assert(index<maxsize_ && usederiv_);
+  const double* d=find(index);
+  if(!d) {
+    for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+    return 0.0;
+  }
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=d[1+i];
+  return d[0];
+}
+
+void TiledSparseGrid::setValue(index_t index, double value) {
+  plumed_assert(index<maxsize_ && !usederiv_);
+  findOrCreate(index)[0]=value;
+}
+
+void TiledSparseGrid::setValueAndDerivatives(index_t index, double value, std::vector<double>& der) {
+  plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  double* d=findOrCreate(index);
+  d[0]=value;
+  for(unsigned int i=0; i<dimension_; ++i) d[1+i]=der[i];
+}
+
+void TiledSparseGrid::addValue(index_t index, double value) {
+  plumed_assert(index<maxsize_ && !usederiv_);
+  findOrCreate(index)[0]+=value;
+}
+
+void TiledSparseGrid::addValueAndDerivatives(index_t index, double value, std::vector<double>& der) {
+  plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  double* d=findOrCreate(index);
+  d[0]+=value;
+  for(unsigned int i=0; i<dimension_; ++i) d[1+i]+=der[i];
+}
+
+void TiledSparseGrid::writeToFile(OFile& ofile) {
+// stored bins are written in the same order used for other grids
+  std::vector<index_t> stored;
+  stored.reserve(nstored_);
+  std::vector<index_t> bins;
+  for(const auto & t : tiles_) {
+    getTileBins(t,bins);
+    for(const auto & b : bins) if(b<maxsize_) stored.push_back(b);
+  }
+  std::sort(stored.begin(),stored.end());
+  std::vector<double> xx(dimension_);
+  std::vector<double> der(dimension_);
+  double f;
+  writeHeader(ofile);
+  ofile.fmtField(" "+fmt_);
+  for(const auto & i : stored) {
+    xx=getPoint(i);
+    if(usederiv_) {f=getValueAndDerivatives(i,der);}
+    else {f=getValue(i);}
+    if(i>0 && dimension_>1 && getIndices(i)[dimension_-2]==0) ofile.printf("\n");
+    for(unsigned j=0; j<dimension_; ++j) {
+      ofile.printField("min_" + argnames[j], str_min_[j] );
+      ofile.printField("max_" + argnames[j], str_max_[j] );
+      ofile.printField("nbins_" + argnames[j], static_cast<int>(nbin_[j]) );
+      if( pbc_[j] ) ofile.printField("periodic_" + argnames[j], "true" );
+      else          ofile.printField("periodic_" + argnames[j], "false" );
+    }
+    for(unsigned j=0; j<dimension_; ++j) ofile.printField(argnames[j],xx[j]);
+    ofile.printField(funcname, f);
+    if(usederiv_) { for(unsigned j=0; j<dimension_; ++j) ofile.printField("der_" + argnames[j],der[j]); }
+    ofile.printField();
+  }
+}
+
+double TiledSparseGrid::getMinValue() const {
+  double minval=0.0;
+  for(index_t i=0; i<data_.size(); i+=stride_) if(data_[i]<minval) minval=data_[i];
+  return minval;
+}
+
+double TiledSparseGrid::getMaxValue() const {
+  double maxval=0.0;
+  for(index_t i=0; i<data_.size(); i+=stride_) if(data_[i]>maxval) maxval=data_[i];
+  return maxval;
+}
+
 void Grid::projectOnLowDimension(double &val, std::vector<int> &vHigh, WeightBase * ptr2obj ) {
   unsigned i=0;
   for(i=0; i<vHigh.size(); i++) {
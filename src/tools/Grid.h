@@ -104,6 +104,8 @@ protected:
   std::vector<double> min_,max_,dx_;
   std::vector<unsigned> nbin_;
   std::vector<bool> pbc_;
+/// distance between consecutive bins along each dimension in the flattened array
+  std::vector<index_t> indexStride_;
   index_t maxsize_;
   unsigned dimension_;
   bool dospline_, usederiv_;
@@ -111,6 +113,12 @@ protected:
 /// get "neighbors" for spline
   void getSplineNeighbors(const std::vector<unsigned> & indices, std::vector<index_t>& neigh, unsigned& nneigh )const;
 // std::vector<index_t> getSplineNeighbors(const std::vector<unsigned> & indices)const;
+/// report an error for an index outside the grid along dimension i
+  [[noreturn]] void outsideGrid(unsigned i) const;
+/// get grid value and derivatives at a point, specialized for grids with dim dimensions.
+/// Only uses arrays allocated on the stack.
+  template<unsigned dim>
+  double interpolate(const double* x, double* der) const;
 
 
 public:
@@ -173,12 +181,13 @@ public:
 /// write header for grid file
   void writeHeader(OFile& file);
 
-/// read grid from file
-  static std::unique_ptr<GridBase> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool);
+/// read grid from file.
+/// If the last argument is true, a sparse grid is stored as a TiledSparseGrid
+  static std::unique_ptr<GridBase> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool,bool=false);
 /// read grid from file and check boundaries are what is expected from input
   static std::unique_ptr<GridBase> create(const std::string&,const std::vector<Value*>&, IFile&,
                                           const std::vector<std::string>&,const std::vector<std::string>&,
-                                          const std::vector<unsigned>&,bool,bool,bool);
+                                          const std::vector<unsigned>&,bool,bool,bool,bool=false);
 /// get grid size
   virtual index_t getSize() const=0;
 /// get grid value
@@ -187,6 +196,8 @@ public:
   double getValue(const std::vector<double> & x) const;
 /// get grid value and derivatives
   virtual double getValueAndDerivatives(index_t index, std::vector<double>& der) const=0;
+/// faster version writing derivatives on a preallocated array of size getDimension()
+  virtual double getValueAndDerivatives(index_t index, double* der) const;
   double getValueAndDerivatives(const std::vector<unsigned> & indices, std::vector<double>& der) const;
   double getValueAndDerivatives(const std::vector<double> & x, std::vector<double>& der) const;
 
@@ -263,6 +274,7 @@ public:
   double getValue(index_t index) const override;
 /// get grid value and derivatives
   double getValueAndDerivatives(index_t index, std::vector<double>& der) const override;
+  double getValueAndDerivatives(index_t index, double* der) const override;
 
 /// set grid value
   void setValue(index_t index, double value) override;
@@ -331,6 +343,7 @@ public:
   double getValue(index_t index) const override;
 /// get grid value and derivatives
   double getValueAndDerivatives(index_t index, std::vector<double>& der) const override;
+  double getValueAndDerivatives(index_t index, double* der) const override;
 
 /// set grid value
   void setValue(index_t index, double value) override;
@@ -350,6 +363,89 @@ public:
 
   virtual ~SparseGrid() {}
 };
+
+/// \ingroup TOOLBOX
+/// Sparse grid stored as a collection of dense tiles.
+/// The grid is split in tiles of contiguous bins (at most 64 bins per tile).
+/// Tiles are allocated when one of their bins is first set, and are located
+/// with an open-addressing hash table. Values and derivatives of each bin are stored
+/// next to each other, so that access has a cost similar to that of a dense grid,
+/// whereas memory is only used in the regions that have been visited.
+/// Bins belonging to an allocated tile are considered as stored, so that getSize()
+/// and writeToFile() might include some bins with zero value.
+class TiledSparseGrid : public GridBase
+{
+/// Number of bins of a tile along each dimension
+  std::vector<unsigned> tileSide_;
+/// Number of tiles along each dimension
+  std::vector<index_t> ntiles_;
+/// Number of bins in a tile
+  unsigned tileSize_;
+/// Number of doubles stored for each bin (value and, if needed, derivatives)
+  unsigned stride_;
+/// Storage for all the tiles, one after the other
+  std::vector<double> data_;
+/// Index of the stored tiles, in the order they were allocated
+  std::vector<index_t> tiles_;
+/// Hash table, containing tile index and position in tiles_ (or empty_ if the slot is free)
+  std::vector<std::pair<index_t,index_t>> table_;
+/// Base-2 logarithm of the size of the hash table
+  unsigned tableBits_;
+/// Number of valid bins in the allocated tiles
+  index_t nstored_;
+/// Marker for free slots in the hash table
+  static constexpr index_t empty_=~index_t(0);
+/// Find the slot of tile in the hash table
+  index_t findSlot(index_t tile) const;
+/// Double the size of the hash table
+  void rehash();
+/// Compute tile and position in the tile of a bin
+  void getTile(index_t index, index_t & tile, unsigned & offset) const;
+/// Pointer to the data of a bin, nullptr if not stored
+  const double* find(index_t index) const;
+/// Pointer to the data of a bin, allocating its tile if needed
+  double* findOrCreate(index_t index);
+/// Global index of the bins of a tile, or maxsize_ for bins outside the grid
+  void getTileBins(index_t tile, std::vector<index_t> & bins) const;
+
+public:
+  TiledSparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                  const std::vector<std::string> & gmax,
+                  const std::vector<unsigned> & nbin, bool dospline, bool usederiv);
+
+  index_t getSize() const override;
+  index_t getMaxSize() const;
+
+/// this is to access to Grid:: version of these methods (allowing overloading of virtual methods)
+  using GridBase::getValue;
+  using GridBase::getValueAndDerivatives;
+  using GridBase::setValue;
+  using GridBase::setValueAndDerivatives;
+  using GridBase::addValue;
+  using GridBase::addValueAndDerivatives;
+
+/// get grid value
+  double getValue(index_t index) const override;
+/// get grid value and derivatives
+  double getValueAndDerivatives(index_t index, std::vector<double>& der) const override;
+  double getValueAndDerivatives(index_t index, double* der) const override;
+
+/// set grid value
+  void setValue(index_t index, double value) override;
+/// set grid value and derivatives
+  void setValueAndDerivatives(index_t index, double value, std::vector<double>& der) override;
+/// add to grid value
+  void addValue(index_t index, double value) override;
+/// add to grid value and derivatives
+  void addValueAndDerivatives(index_t index, double value, std::vector<double>& der) override;
+
+/// get minimum value
+  double getMinValue() const override;
+/// get maximum value
+  double getMaxValue() const override;
+/// dump grid on file
+  void writeToFile(OFile&) override;
+};
 }
 
 #endif
@@ -27,8 +27,13 @@
 #include "Communicator.h"
 #include "Tools.h"
 #include <cstdarg>
+#include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <limits>
 
 #include <iostream>
 #include <string>
@@ -38,6 +43,66 @@
 
 namespace PLMD {
 
+/// Size of the chunks read at once when the file is buffered
+static const std::size_t bufferChunk=65536;
+
+/// Fast conversion of plain decimal numbers.
+/// Anything else (e.g. pi or expressions) is left to Tools::convert()
+static bool convertFast(const char* str,double & x) {
+  for(const char* p=str; *p; ++p) {
+    if(!std::isdigit(static_cast<unsigned char>(*p)) && *p!='.' && *p!='-' && *p!='+' && *p!='e' && *p!='E') return false;
+  }
+  char* end;
+  x=std::strtod(str,&end);
+  return end!=str && *end=='\0';
+}
+
+/// Reverse the byte order of a number
+template<typename T>
+static void byteSwap(T & x) {
+  char* c=reinterpret_cast<char*>(&x);
+  std::reverse(c,c+sizeof(T));
+}
+
+/// Format a double read from a binary file so that it can be converted back exactly
+static std::string formatBinaryDouble(double x) {
+  char buf[32];
+  std::snprintf(buf,sizeof(buf),"%.17g",x);
+  return buf;
+}
+
+/// Decoder for the records of a binary file stored in a buffer.
+/// All the methods return false if the record is incomplete, in which case
+/// the record should be decoded again after reading more data
+class BinaryDecoder {
+  const char* p;
+  const char* end;
+  bool swap;
+public:
+  BinaryDecoder(const char* begin,const char* end,bool swap): p(begin), end(end), swap(swap) {}
+  const char* position()const {return p;}
+  void setSwap(bool s) {swap=s;}
+  bool getBytes(void* ptr,std::size_t n) {
+    if(std::size_t(end-p)<n) return false;
+    std::memcpy(ptr,p,n);
+    p+=n;
+    return true;
+  }
+  template<typename T>
+  bool get(T & x) {
+    if(!getBytes(&x,sizeof(T))) return false;
+    if(swap) byteSwap(x);
+    return true;
+  }
+  bool get(std::string & str) {
+    std::uint32_t n;
+    if(!get(n) || std::size_t(end-p)<n) return false;
+    str.assign(p,n);
+    p+=n;
+    return true;
+  }
+};
+
 size_t IFile::llread(char*ptr,size_t s) {
   plumed_assert(fp);
   size_t r;
@@ -58,29 +123,157 @@ size_t IFile::llread(char*ptr,size_t s) {
   return r;
 }
 
+bool IFile::fillBuffer() {
+// move the bytes that have not been used yet to the beginning of the buffer
+  if(bufferStart>0) {
+    std::memmove(buffer.data(),buffer.data()+bufferStart,bufferEnd-bufferStart);
+    bufferEnd-=bufferStart;
+    bufferStart=0;
+  }
+// make room for lines longer than the buffer
+  if(buffer.size()-bufferEnd<bufferChunk) buffer.resize(bufferEnd+bufferChunk);
+  size_t r=llread(buffer.data()+bufferEnd,buffer.size()-bufferEnd);
+// end of file is reported by getline() only once the buffer has been used
+  eof=false;
+  bufferEnd+=r;
+  return r>0;
+}
+
+char IFile::nextBinaryRecord() {
+  if(bufferStart==bufferEnd && !fillBuffer()) {
+    eof=true;
+    return 0;
+  }
+  const char c=buffer[bufferStart];
+  plumed_massert(c=='D' || c==binaryMagic[0],"file " + getPath() + ": corrupted binary file");
+  return c=='D' ? 'D' : 'H';
+}
+
+bool IFile::readBinaryHeader() {
+  std::vector<Field> newfields;
+  bool swap=false;
+  while(true) {
+    BinaryDecoder d(buffer.data()+bufferStart,buffer.data()+bufferEnd,false);
+    auto decode=[&]() -> bool {
+      char magic[sizeof(binaryMagic)];
+      std::uint32_t version,order,n;
+      if(!d.getBytes(magic,sizeof(magic)) || !d.get(version) || !d.get(order)) return false;
+      plumed_massert(std::memcmp(magic,binaryMagic,sizeof(magic))==0,"file " + getPath() + ": corrupted binary file");
+      swap=(order!=binaryByteOrder);
+      if(swap) {
+        byteSwap(order);
+        byteSwap(version);
+        plumed_massert(order==binaryByteOrder,"file " + getPath() + ": corrupted binary file");
+        d.setSwap(true);
+      }
+      plumed_massert(version<=binaryVersion,"file " + getPath() + ": binary format written by a newer version of PLUMED");
+      newfields.clear();
+      if(!d.get(n)) return false;
+      for(unsigned i=0; i<n; i++) {
+        Field field;
+        if(!d.get(field.name)) return false;
+        newfields.push_back(field);
+      }
+      if(!d.get(n)) return false;
+      for(unsigned i=0; i<n; i++) {
+        Field field;
+        field.constant=true;
+        if(!d.get(field.name) || !d.get(field.value)) return false;
+        newfields.push_back(field);
+      }
+      return true;
+    };
+    if(decode()) {
+      bufferStart=d.position()-buffer.data();
+      fields=std::move(newfields);
+      binarySwap=swap;
+      return true;
+    }
+    if(!fillBuffer()) {
+      eof=true;
+      return false;
+    }
+  }
+}
+
+bool IFile::readBinaryFields() {
+  while(true) {
+    BinaryDecoder d(buffer.data()+bufferStart,buffer.data()+bufferEnd,binarySwap);
+    auto decode=[&]() -> bool {
+      char tag;
+      if(!d.get(tag)) return false;
+      for(auto & f : fields) {
+        if(f.constant) continue;
+        char type;
+        if(!d.get(type)) return false;
+        plumed_massert(type=='d' || type=='s',"file " + getPath() + ": corrupted binary file");
+        f.isDouble=(type=='d');
+        if(f.isDouble) {
+          if(!d.get(f.dvalue)) return false;
+        } else {
+          if(!d.get(f.value)) return false;
+        }
+        f.read=false;
+      }
+      return true;
+    };
+    if(decode()) {
+      bufferStart=d.position()-buffer.data();
+      return true;
+    }
+    if(!fillBuffer()) {
+      eof=true;
+      return false;
+    }
+  }
+}
+
 IFile& IFile::advanceField() {
   plumed_assert(!inMiddleOfField);
+  if(binary) {
+    while(true) {
+      const char type=nextBinaryRecord();
+      if(type==0) return *this;
+      if(type=='H') {
+        if(!readBinaryHeader()) return *this;
+      } else {
+        if(!readBinaryFields()) return *this;
+        break;
+      }
+    }
+    inMiddleOfField=true;
+    return *this;
+  }
   std::string line;
+  std::vector<std::string> words;
   bool done=false;
   while(!done) {
     getline(line);
 // using explicit conversion not to confuse cppcheck 1.86
     if(!bool(*this)) {return *this;}
-    std::vector<std::string> words=Tools::getWords(line);
-    if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
-      fields.clear();
-      for(unsigned i=2; i<words.size(); i++) {
+// only lines starting with #! need to be checked for headers
+    bool header=false;
+    const size_t first=line.find_first_not_of(" \t");
+    if(first!=std::string::npos && line.compare(first,2,"#!")==0) {
+      words=Tools::getWords(line);
+      if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
+        fields.clear();
+        for(unsigned i=2; i<words.size(); i++) {
+          Field field;
+          field.name=words[i];
+          fields.push_back(field);
+        }
+        header=true;
+      } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
         Field field;
-        field.name=words[i];
+        field.name=words[2];
+        field.value=words[3];
+        field.constant=true;
         fields.push_back(field);
+        header=true;
       }
-    } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
-      Field field;
-      field.name=words[2];
-      field.value=words[3];
-      field.constant=true;
-      fields.push_back(field);
-    } else {
+    }
+    if(!header) {
       unsigned nf=0;
       for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) nf++;
       Tools::trimComments(line);
@@ -112,6 +305,12 @@ IFile& IFile::open(const std::string&path) {
   bool do_exist=FileExist(path);
   plumed_massert(do_exist,"file " + path + " cannot be found");
   fp=std::fopen(const_cast<char*>(this->path.c_str()),"r");
+// files opened by name are read in large chunks
+  buffered=true;
+  buffer.resize(bufferChunk);
+  bufferStart=0;
+  bufferEnd=0;
+  hasPushedBackLine=false;
   if(Tools::extension(this->path)=="gz") {
 #ifdef __PLUMED_HAS_ZLIB
     gzfp=(void*)gzopen(const_cast<char*>(this->path.c_str()),"r");
@@ -119,6 +318,10 @@ IFile& IFile::open(const std::string&path) {
     plumed_merror("file " + getPath() + ": trying to use a gz file without zlib being linked");
 #endif
   }
+// binary files are recognized from their first bytes
+  while(bufferEnd<sizeof(binaryMagic) && fillBuffer()) {}
+  binary=(bufferEnd>=sizeof(binaryMagic) && std::memcmp(buffer.data(),binaryMagic,sizeof(binaryMagic))==0);
+  binarySwap=false;
   if(plumed) plumed->insertFile(*this);
   return *this;
 }
@@ -134,11 +337,100 @@ IFile& IFile::scanFieldList(std::vector<std::string>&s) {
 }
 
 bool IFile::FieldExist(const std::string& s) {
-  std::vector<std::string> slist;
-  scanFieldList(slist);
-  int mycount = (int) std::count(slist.begin(), slist.end(), s);
-  if(mycount>0) return true;
-  else return false;
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return false;
+  for(unsigned i=0; i<fields.size(); i++) if(fields[i].name==s) return true;
+  return false;
+}
+
+void IFile::getColumnList(std::vector<std::string>&s)const {
+  s.clear();
+  for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) s.push_back(fields[i].name);
+}
+
+std::size_t IFile::scanColumns(const std::vector<std::string>&names,std::vector<std::vector<double> >&columns,std::size_t maxlines) {
+  plumed_massert(!inMiddleOfField,"file " + getPath() + ": scanColumns() should be called after completing a line with scanField()");
+  columns.resize(names.size());
+  for(auto & c : columns) c.clear();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this) || maxlines==0) return 0;
+
+// position of each field among the words of a line
+  std::vector<unsigned> word(fields.size(),0);
+  unsigned nf=0;
+  for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) word[i]=nf++;
+  std::vector<unsigned> index(names.size());
+  std::vector<unsigned> position(names.size());
+  std::vector<bool> requested(fields.size(),false);
+  for(unsigned j=0; j<names.size(); j++) {
+    unsigned i=findField(names[j]);
+    plumed_massert(!fields[i].constant,"file " + getPath() + ": field " + names[j] + " is constant and cannot be read with scanColumns()");
+    index[j]=i;
+    position[j]=word[i];
+    requested[i]=true;
+  }
+  if(!ignoreFields) {
+    for(unsigned i=0; i<fields.size(); i++) {
+      plumed_massert(fields[i].constant || requested[i],"field "+fields[i].name+" was not read: all the fields need to be read otherwise you could miss important infos" );
+    }
+  }
+
+  if(binary) {
+    std::size_t nlines=0;
+// headers are left for the next call to scanField()
+    while(nlines<maxlines && nextBinaryRecord()=='D' && readBinaryFields()) {
+      for(unsigned j=0; j<names.size(); j++) {
+        const Field & f(fields[index[j]]);
+        double x=f.dvalue;
+        if(!f.isDouble && !convertFast(f.value.c_str(),x)) Tools::convert(f.value,x);
+        columns[j].push_back(x);
+      }
+      nlines++;
+    }
+    return nlines;
+  }
+
+  std::string line;
+  std::vector<const char*> words(nf);
+  std::size_t nlines=0;
+  while(nlines<maxlines) {
+    getline(line);
+    if(!bool(*this)) break;
+    const size_t first=line.find_first_not_of(" \t");
+// headers are left for the next call to scanField()
+    if(first!=std::string::npos && line.compare(first,2,"#!")==0) {
+      pushedBackLine=line;
+      hasPushedBackLine=true;
+      break;
+    }
+    Tools::trimComments(line);
+// split the line in place, terminating each word with a null character
+    unsigned nw=0;
+    char* p=&line[0];
+    char* end=p+line.size();
+    while(true) {
+      while(p<end && (*p==' ' || *p=='\t' || *p=='\n')) p++;
+      if(p==end) break;
+      if(nw<nf) words[nw]=p;
+      nw++;
+      while(p<end && *p!=' ' && *p!='\t' && *p!='\n') p++;
+      if(p<end) *p++='\0';
+    }
+    if(nw==0) continue;
+    if(nw!=nf) {
+      std::replace(line.begin(),line.end(),'\0',' ');
+      plumed_merror("file " + getPath() + ": mismatch between number of fields in file and expected number\n this is the faulty line:\n"+line);
+    }
+    for(unsigned j=0; j<names.size(); j++) {
+      double x=std::numeric_limits<double>::quiet_NaN();
+      const char* w=words[position[j]];
+      if(!convertFast(w,x)) Tools::convert(std::string(w),x);
+      columns[j].push_back(x);
+    }
+    nlines++;
+  }
+  return nlines;
 }
 
 IFile& IFile::scanField(const std::string&name,std::string&str) {
@@ -146,15 +438,19 @@ IFile& IFile::scanField(const std::string&name,std::string&str) {
 // using explicit conversion not to confuse cppcheck 1.86
   if(!bool(*this)) return *this;
   unsigned i=findField(name);
-  str=fields[i].value;
+  str=fields[i].isDouble ? formatBinaryDouble(fields[i].dvalue) : fields[i].value;
   fields[i].read=true;
   return *this;
 }
 
 IFile& IFile::scanField(const std::string&name,double &x) {
-  std::string str;
-  scanField(name,str);
-  if(*this) Tools::convert(str,x);
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return *this;
+  unsigned i=findField(name);
+  fields[i].read=true;
+  if(fields[i].isDouble) x=fields[i].dvalue;
+  else if(!convertFast(fields[i].value.c_str(),x)) Tools::convert(fields[i].value,x);
   return *this;
 }
 
@@ -228,7 +524,12 @@ IFile& IFile::scanField() {
 IFile::IFile():
   inMiddleOfField(false),
   ignoreFields(false),
-  noEOL(false)
+  noEOL(false),
+  buffered(false),
+  bufferStart(0),
+  bufferEnd(0),
+  hasPushedBackLine(false),
+  binarySwap(false)
 {
 }
 
@@ -237,6 +538,42 @@ IFile::~IFile() {
 }
 
 IFile& IFile::getline(std::string &str) {
+  if(hasPushedBackLine) {
+    str=pushedBackLine;
+    hasPushedBackLine=false;
+    return *this;
+  }
+  if(buffered) {
+    plumed_massert(!binary,"file " + getPath() + ": lines cannot be read from a binary file");
+    str.clear();
+    if(eof || err) return *this;
+// number of bytes already checked for a newline
+    size_t checked=0;
+    while(true) {
+      const char* begin=buffer.data()+bufferStart;
+      const char* nl=static_cast<const char*>(std::memchr(begin+checked,'\n',bufferEnd-bufferStart-checked));
+      if(nl) {
+        size_t len=nl-begin;
+        bufferStart+=len+1;
+        if(len>0 && begin[len-1]=='\r') len--;
+        str.assign(begin,len);
+        plumed_massert(str.find('\r')==std::string::npos,"plumed only accepts \\n (unix) or \\r\\n (dos) new lines");
+        return *this;
+      }
+      checked=bufferEnd-bufferStart;
+      if(!fillBuffer()) break;
+    }
+// the last line is incomplete
+    if(noEOL && bufferEnd>bufferStart) {
+      str.assign(buffer.data()+bufferStart,bufferEnd-bufferStart);
+      bufferStart=bufferEnd;
+    } else {
+// the incomplete line is kept in the buffer, so that it can be completed
+// if the file is read again after reset(false)
+      eof=true;
+    }
+    return *this;
+  }
   char tmp=0;
   str="";
   fpos_t pos;
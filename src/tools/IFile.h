@@ -45,7 +45,10 @@ class IFile:
     public FieldBase {
   public:
     bool read;
-    Field(): read(false) {}
+/// In binary files doubles are stored as such, without formatting
+    bool isDouble;
+    double dvalue;
+    Field(): read(false), isDouble(false), dvalue(0.0) {}
   };
 /// Low-level read.
 /// Note: in parallel, all processes read
@@ -58,6 +61,26 @@ class IFile:
   bool ignoreFields;
 /// Set to true to allow files without end-of-line at the end
   bool noEOL;
+/// Set to true when the file is read in large chunks stored in buffer
+  bool buffered;
+/// Buffer used when reading in large chunks.
+/// Bytes between bufferStart and bufferEnd have been read from the file but not used yet
+  std::vector<char> buffer;
+  std::size_t bufferStart;
+  std::size_t bufferEnd;
+/// Line that has been read but should be returned again by the next getline()
+  std::string pushedBackLine;
+  bool hasPushedBackLine;
+/// Read more data into the buffer. Returns false if no data is available
+  bool fillBuffer();
+/// Set to true if numbers in a binary file have a byte order different from the native one
+  bool binarySwap;
+/// Type of the next record of a binary file: 'H' for a header, 'D' for a line of fields, 0 at end of file
+  char nextBinaryRecord();
+/// Read a header of a binary file. Returns false if it is incomplete
+  bool readBinaryHeader();
+/// Read a line of fields of a binary file. Returns false if it is incomplete
+  bool readBinaryFields();
 /// Advance to next field (= read one line)
   IFile& advanceField();
 /// Find field index by name
@@ -87,6 +110,18 @@ public:
   IFile& scanField(const std::string&,long long unsigned&);
 /// Read a string field
   IFile& scanField(const std::string&,std::string&);
+/// Gets the list of fields that are not constant, as found in the last header.
+/// Differently from scanFieldList(), it never reads a new line.
+  void getColumnList(std::vector<std::string>&)const;
+/// Read many lines at once, storing the requested fields column by column.
+/// It should be called after a line has been completed with scanField(), and
+/// reads at most maxlines of the lines that follow, provided they have the same fields.
+/// Field positions are resolved once and numbers are converted with a fast parser,
+/// so that this is much faster than reading the same lines with scanField().
+/// Columns are overwritten and contain the values of name[i] in columns[i].
+/// Returns the number of lines read, which is zero at the end of file or when
+/// a new header is found. In the latter case, the header is processed by the next scanField().
+  std::size_t scanColumns(const std::vector<std::string>&names,std::vector<std::vector<double> >&columns,std::size_t maxlines);
   /**
    Ends a field-formatted line.
 
@@ -22,6 +22,7 @@
 #include "LinkCells.h"
 #include "Communicator.h"
 #include "Tools.h"
+#include "OpenMP.h"
 
 namespace PLMD {
 
@@ -75,30 +76,45 @@ void LinkCells::buildCellLists( const std::vector<Vector>& pos, const std::vecto
   if( lcell_tots.size()!=ncellstot ) {
     lcell_tots.resize( ncellstot ); lcell_starts.resize( ncellstot );
   }
-  // Clear nlcells
-  for(unsigned i=0; i<ncellstot; ++i) lcell_tots[i]=0;
-  // Clear allcells
-  allcells.assign( allcells.size(), 0 );
-
-  // Find out what cell everyone is in
+  // Find out what cell everyone is in, each process doing a contiguous block of atoms
   unsigned rank=comm.Get_rank(), size=comm.Get_size();
-  for(unsigned i=rank; i<pos.size(); i+=size) {
-    allcells[i]=findCell( pos[i] );
-    lcell_tots[allcells[i]]++;
-  }
+  unsigned natoms=pos.size(), nt=OpenMP::getGoodNumThreads(allcells);
+  unsigned first=(natoms*rank)/size, last=(natoms*(rank+1))/size;
+  allcells.assign( allcells.size(), 0 );
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned i=first; i<last; ++i) allcells[i]=findCell( pos[i] );
   // And gather all this information on every node
-  comm.Sum( allcells ); comm.Sum( lcell_tots );
-
-  // Now prepare the link cell lists
-  unsigned tot=0;
-  for(unsigned i=0; i<lcell_tots.size(); ++i) { lcell_starts[i]=tot; tot+=lcell_tots[i]; lcell_tots[i]=0; }
-  plumed_assert( tot==pos.size() );
-
-  // And setup the link cells properly
-  for(unsigned j=0; j<pos.size(); ++j) {
-    unsigned myind = lcell_starts[ allcells[j] ] + lcell_tots[ allcells[j] ];
-    lcell_lists[ myind ] = indices[j];
-    lcell_tots[allcells[j]]++;
+  comm.Sum( allcells );
+
+  // Now prepare the link cell lists. Atoms are split in chunks, and the atoms of each chunk
+  // are counted separately so that the chunks can be sorted in parallel into the lists.
+  // This is not worth when there are many more cells than atoms.
+  unsigned nchunks=( ncellstot<=natoms ? nt : 1 );
+  std::vector<unsigned> chunk_tots( nchunks*ncellstot, 0 );
+  #pragma omp parallel num_threads(nt)
+  {
+    #pragma omp for schedule(static)
+    for(unsigned c=0; c<nchunks; ++c) {
+      unsigned* mytots=&chunk_tots[c*ncellstot];
+      for(unsigned j=(natoms*c)/nchunks; j<(natoms*(c+1))/nchunks; ++j) mytots[allcells[j]]++;
+    }
+    #pragma omp single
+    {
+      unsigned tot=0;
+      for(unsigned i=0; i<ncellstot; ++i) {
+        lcell_starts[i]=tot;
+        // after this loop chunk_tots contains the position of the first atom of each chunk in each cell
+        for(unsigned c=0; c<nchunks; ++c) { unsigned n=chunk_tots[c*ncellstot+i]; chunk_tots[c*ncellstot+i]=tot; tot+=n; }
+        lcell_tots[i]=tot-lcell_starts[i];
+      }
+      plumed_assert( tot==natoms );
+    }
+    // And setup the link cells properly
+    #pragma omp for schedule(static)
+    for(unsigned c=0; c<nchunks; ++c) {
+      unsigned* mystarts=&chunk_tots[c*ncellstot];
+      for(unsigned j=(natoms*c)/nchunks; j<(natoms*(c+1))/nchunks; ++j) lcell_lists[ mystarts[allcells[j]]++ ]=indices[j];
+    }
   }
 }
 
@@ -167,6 +183,14 @@ unsigned LinkCells::convertIndicesToIndex( const unsigned& nx, const unsigned& n
   return nx*nstride[0] + ny*nstride[1] + nz*nstride[2];
 }
 
+std::array<unsigned,3> LinkCells::convertIndexToIndices( const unsigned& index ) const {
+  std::array<unsigned,3> celn;
+  celn[2] = index / nstride[2];
+  celn[1] = ( index - celn[2]*nstride[2] ) / nstride[1];
+  celn[0] = index - celn[2]*nstride[2] - celn[1]*nstride[1];
+  return celn;
+}
+
 unsigned LinkCells::findCell( const Vector& pos ) const {
   std::array<unsigned,3> celn( findMyCell(pos ) );
   return convertIndicesToIndex( celn[0], celn[1], celn[2] );
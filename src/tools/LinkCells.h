@@ -69,6 +69,12 @@ public:
   void buildCellLists( const std::vector<Vector>& pos, const std::vector<unsigned>& indices, const Pbc& pbc );
 /// Take three indices and return the index of the corresponding cell
   unsigned convertIndicesToIndex( const unsigned& nx, const unsigned& ny, const unsigned& nz ) const ;
+/// Take the index of a cell and return the three corresponding indices
+  std::array<unsigned,3> convertIndexToIndices( const unsigned& index ) const ;
+/// Get the number of atoms in a particular cell
+  unsigned getNumberOfAtomsInCell( const unsigned& cell ) const ;
+/// Get the k-th atom in a particular cell
+  unsigned getAtomInCell( const unsigned& cell, const unsigned& k ) const ;
 /// Find the cell index in which this position is contained
   unsigned findCell( const Vector& pos ) const ;
 /// Find the cell in which this position is contained
@@ -94,6 +100,16 @@ unsigned LinkCells::getNumberOfCells() const {
   return ncells[0]*ncells[1]*ncells[2];
 }
 
+inline
+unsigned LinkCells::getNumberOfAtomsInCell( const unsigned& cell ) const {
+  return lcell_tots[cell];
+}
+
+inline
+unsigned LinkCells::getAtomInCell( const unsigned& cell, const unsigned& k ) const {
+  return lcell_lists[lcell_starts[cell]+k];
+}
+
 }
 
 #endif
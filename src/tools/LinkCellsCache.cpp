@@ -0,0 +1,55 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2012-2022 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "LinkCellsCache.h"
+#include "LinkCells.h"
+#include "Pbc.h"
+#include "Tools.h"
+
+namespace PLMD {
+
+std::shared_ptr<const LinkCells> LinkCellsCache::get( Communicator& comm, const double& cutoff, const std::vector<Vector>& pos,
+    const std::vector<unsigned>& indices, const Pbc& pbc ) {
+  const Tensor & box=pbc.getBox();
+  for(const auto & e : entries) {
+    // cheaper checks first
+    if( e.cutoff!=cutoff || e.indices.size()!=indices.size() ) continue;
+    bool same=true;
+    for(unsigned i=0; i<3 && same; ++i) for(unsigned j=0; j<3 && same; ++j) same=( e.box[i][j]==box[i][j] );
+    if( !same || e.indices!=indices ) continue;
+    for(unsigned i=0; i<pos.size() && same; ++i) same=( e.positions[i][0]==pos[i][0] && e.positions[i][1]==pos[i][1] && e.positions[i][2]==pos[i][2] );
+    if( same ) return e.cells;
+  }
+  auto cells=Tools::make_unique<LinkCells>( comm );
+  cells->setCutoff( cutoff );
+  cells->buildCellLists( pos, indices, pbc );
+  Entry e;
+  e.cutoff=cutoff; e.box=box; e.indices=indices; e.positions=pos;
+  e.cells=std::move(cells);
+  entries.push_back( std::move(e) );
+  return entries.back().cells;
+}
+
+void LinkCellsCache::clear() {
+  entries.clear();
+}
+
+}
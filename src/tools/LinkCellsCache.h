@@ -0,0 +1,71 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2012-2022 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_LinkCellsCache_h
+#define __PLUMED_tools_LinkCellsCache_h
+
+#include <vector>
+#include <memory>
+#include "Vector.h"
+#include "Tensor.h"
+
+namespace PLMD {
+
+class Communicator;
+class LinkCells;
+class Pbc;
+
+/**
+\ingroup TOOLBOX
+Class storing link cells so that they can be shared by several actions.
+
+Actions that use the same atoms with the same cutoff (e.g. many coordination numbers
+computed on the same group of atoms) would otherwise build identical link cells.
+With this class the link cells are built by the first of these actions and then reused by
+the others, which access them read-only.
+Link cells are reused only when the cutoff, the box, the indices and the positions are
+exactly equal to those they were built for, so that the result does not
+depend on whether they are shared or not.
+Since the positions are identical on all the processes, either all or none of them
+reuse the link cells, as required by the communications in LinkCells::buildCellLists().
+The cache should be cleared at every step so as not to accumulate old link cells.
+*/
+class LinkCellsCache {
+/// Link cells together with the data they were built from
+  struct Entry {
+    double cutoff;
+    Tensor box;
+    std::vector<unsigned> indices;
+    std::vector<Vector> positions;
+    std::shared_ptr<const LinkCells> cells;
+  };
+  std::vector<Entry> entries;
+public:
+/// Get link cells for a set of positions, building them if they are not stored yet
+  std::shared_ptr<const LinkCells> get( Communicator& comm, const double& cutoff, const std::vector<Vector>& pos,
+                                        const std::vector<unsigned>& indices, const Pbc& pbc );
+/// Remove all the stored link cells. Link cells already returned by get() stay valid
+  void clear();
+};
+
+}
+
+#endif
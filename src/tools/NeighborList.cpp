@@ -26,6 +26,7 @@
 #include "Communicator.h"
 #include "OpenMP.h"
 #include "Tools.h"
+#include "LinkCells.h"
 #include <vector>
 #include <algorithm>
 #include <numeric>
@@ -35,7 +36,7 @@ namespace PLMD {
 NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const std::vector<AtomNumber>& list1,
                            const bool& serial, const bool& do_pair, const bool& do_pbc, const Pbc& pbc, Communicator& cm,
                            const double& distance, const unsigned& stride): reduced(false),
-  serial_(serial), do_pair_(do_pair), do_pbc_(do_pbc), pbc_(&pbc), comm(cm),
+  serial_(serial), do_pair_(do_pair), do_pbc_(do_pbc), use_cells_(true), pbc_(&pbc), comm(cm),
   distance_(distance), stride_(stride)
 {
 // store full list of atoms needed
@@ -58,7 +59,7 @@ NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const std::vect
 NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const bool& serial, const bool& do_pbc,
                            const Pbc& pbc, Communicator& cm, const double& distance,
                            const unsigned& stride): reduced(false),
-  serial_(serial), do_pbc_(do_pbc), pbc_(&pbc), comm(cm),
+  serial_(serial), do_pbc_(do_pbc), use_cells_(true), pbc_(&pbc), comm(cm),
   distance_(distance), stride_(stride) {
   fullatomlist_=list0;
   nlist0_=list0.size();
@@ -68,6 +69,10 @@ NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const bool& ser
   lastupdate_=0;
 }
 
+NeighborList::~NeighborList() {
+// destructor required to delete forward declared classes
+}
+
 void NeighborList::initialize() {
   neighbors_.clear();
   for(unsigned int i=0; i<nallpairs_; ++i) {
@@ -94,22 +99,13 @@ std::pair<unsigned,unsigned> NeighborList::getIndexPair(unsigned ipair) {
   return index;
 }
 
-void NeighborList::update(const std::vector<Vector>& positions) {
-  neighbors_.clear();
-  const double d2=distance_*distance_;
-  // check if positions array has the correct length
-  plumed_assert(positions.size()==fullatomlist_.size());
-
-  unsigned stride=comm.Get_size();
-  unsigned rank=comm.Get_rank();
-  unsigned nt=OpenMP::getNumThreads();
-  if(serial_) {
-    stride=1;
-    rank=0;
-    nt=1;
-  }
-  std::vector<unsigned> local_flat_nl;
+bool NeighborList::useLinkCells() const {
+// with PAIR the number of pairs is already linear in the number of atoms
+  return use_cells_ && do_pbc_ && !(twolists_ && do_pair_) && pbc_->isSet();
+}
 
+void NeighborList::findPairsAllPairs(const std::vector<Vector>& positions, unsigned rank, unsigned stride, unsigned nt, std::vector<unsigned>& flat_nl) {
+  const double d2=distance_*distance_;
   #pragma omp parallel num_threads(nt)
   {
     std::vector<unsigned> private_flat_nl;
@@ -131,8 +127,80 @@ void NeighborList::update(const std::vector<Vector>& positions) {
       }
     }
     #pragma omp critical
-    local_flat_nl.insert(local_flat_nl.end(), private_flat_nl.begin(), private_flat_nl.end());
+    flat_nl.insert(flat_nl.end(), private_flat_nl.begin(), private_flat_nl.end());
+  }
+}
+
+void NeighborList::findPairsLinkCells(const std::vector<Vector>& positions, unsigned rank, unsigned stride, unsigned nt, std::vector<unsigned>& flat_nl) {
+  if(!cells_) {
+    if(serial_) {
+      serialcomm_=Tools::make_unique<Communicator>();
+      cells_=Tools::make_unique<LinkCells>(*serialcomm_);
+    } else cells_=Tools::make_unique<LinkCells>(comm);
+  }
+  const double d2=distance_*distance_;
+// all the atoms are stored in the cells, the pairs are then found
+// looping over the cells so that work is split by cells among ranks and threads
+  std::vector<unsigned> indices(positions.size());
+  std::iota(indices.begin(),indices.end(),0);
+  cells_->setCutoff(distance_);
+  cells_->buildCellLists(positions,indices,*pbc_);
+  const unsigned ncells=cells_->getNumberOfCells();
+
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<unsigned> private_flat_nl;
+    std::vector<unsigned> cells_required(ncells);
+    std::vector<unsigned> atoms(positions.size());
+    #pragma omp for nowait
+    for(unsigned int c=rank; c<ncells; c+=stride) {
+      const unsigned natoms=cells_->getNumberOfAtomsInCell(c);
+      if(natoms==0) continue;
+      unsigned ncells_required=0;
+      cells_->addRequiredCells(cells_->convertIndexToIndices(c),ncells_required,cells_required);
+      for(unsigned k=0; k<natoms; ++k) {
+        unsigned index0=cells_->getAtomInCell(c,k);
+        if(twolists_ && index0>=nlist0_) continue;
+        atoms[0]=index0;
+        unsigned natomsper=1;
+        cells_->retrieveAtomsInCells(ncells_required,cells_required,natomsper,atoms);
+        for(unsigned j=1; j<natomsper; ++j) {
+          unsigned index1=atoms[j];
+// each pair is only counted once, with the same ordering used by getIndexPair
+          if(twolists_) {
+            if(index1<nlist0_) continue;
+          } else if(index1<index0) continue;
+          Vector distance=pbc_->distance(positions[index0],positions[index1]);
+          double value=modulo2(distance);
+          if(value<=d2) {
+            private_flat_nl.push_back(index0);
+            private_flat_nl.push_back(index1);
+          }
+        }
+      }
+    }
+    #pragma omp critical
+    flat_nl.insert(flat_nl.end(), private_flat_nl.begin(), private_flat_nl.end());
   }
+}
+
+void NeighborList::update(const std::vector<Vector>& positions) {
+  neighbors_.clear();
+  // check if positions array has the correct length
+  plumed_assert(positions.size()==fullatomlist_.size());
+
+  unsigned stride=comm.Get_size();
+  unsigned rank=comm.Get_rank();
+  unsigned nt=OpenMP::getNumThreads();
+  if(serial_) {
+    stride=1;
+    rank=0;
+    nt=1;
+  }
+  std::vector<unsigned> local_flat_nl;
+  const bool cells=useLinkCells();
+  if(cells) findPairsLinkCells(positions,rank,stride,nt,local_flat_nl);
+  else findPairsAllPairs(positions,rank,stride,nt,local_flat_nl);
 
   // find total dimension of neighborlist
   std::vector <int> local_nl_size(stride, 0);
@@ -159,6 +227,9 @@ void NeighborList::update(const std::vector<Vector>& positions) {
     unsigned j=2*i;
     neighbors_[i] = std::make_pair(merge_nl[j],merge_nl[j+1]);
   }
+  // pairs found with link cells come in cell order, sort them
+  // so that the list does not depend on the number of cells, ranks and threads
+  if(cells) std::sort(neighbors_.begin(),neighbors_.end());
 
   setRequestList();
 }
@@ -199,6 +270,10 @@ void NeighborList::setLastUpdate(unsigned step) {
   lastupdate_=step;
 }
 
+void NeighborList::setLinkCells(bool use) {
+  use_cells_=use;
+}
+
 unsigned NeighborList::size() const {
   return neighbors_.size();
 }
@@ -26,11 +26,13 @@
 #include "AtomNumber.h"
 
 #include <vector>
+#include <memory>
 
 namespace PLMD {
 
 class Pbc;
 class Communicator;
+class LinkCells;
 
 /// \ingroup TOOLBOX
 /// A class that implements neighbor lists from two lists or a single list of atoms
@@ -39,12 +41,17 @@ class NeighborList
   bool reduced;
   bool serial_;
   bool do_pair_,do_pbc_,twolists_;
+  bool use_cells_;
   const PLMD::Pbc* pbc_;
   Communicator& comm;
   std::vector<PLMD::AtomNumber> fullatomlist_,requestlist_;
   std::vector<std::pair<unsigned,unsigned> > neighbors_;
   double distance_;
   unsigned stride_,nlist0_,nlist1_,nallpairs_,lastupdate_;
+/// Communicator used by the link cells when running in serial
+  std::unique_ptr<Communicator> serialcomm_;
+/// Link cells used to rebuild the list
+  std::unique_ptr<LinkCells> cells_;
 /// Initialize the neighbor list with all possible pairs
   void initialize();
 /// Return the pair of indexes in the positions array
@@ -52,6 +59,12 @@ class NeighborList
   std::pair<unsigned,unsigned> getIndexPair(unsigned i);
 /// Extract the list of atoms from the current list of close pairs
   void setRequestList();
+/// Check if the list can be rebuilt using link cells
+  bool useLinkCells() const;
+/// Find the close pairs by looping over all the possible pairs
+  void findPairsAllPairs(const std::vector<PLMD::Vector>& positions, unsigned rank, unsigned stride, unsigned nt, std::vector<unsigned>& flat_nl);
+/// Find the close pairs by looping over link cells
+  void findPairsLinkCells(const std::vector<PLMD::Vector>& positions, unsigned rank, unsigned stride, unsigned nt, std::vector<unsigned>& flat_nl);
 public:
   NeighborList(const std::vector<PLMD::AtomNumber>& list0,
                const std::vector<PLMD::AtomNumber>& list1,
@@ -78,13 +91,16 @@ public:
   unsigned getLastUpdate() const;
 /// Set the step of the last update
   void setLastUpdate(unsigned step);
+/// Enable or disable the use of link cells when rebuilding the list.
+/// Link cells are only used with pbc and when a box is set, otherwise all the pairs are scanned
+  void setLinkCells(bool use);
 /// Get the size of the neighbor list
   unsigned size() const;
 /// Get the i-th pair of the neighbor list
   std::pair<unsigned,unsigned> getClosePair(unsigned i) const;
 /// Get the list of neighbors of the i-th atom
   std::vector<unsigned> getNeighbors(unsigned i);
-  ~NeighborList() {}
+  ~NeighborList();
 /// Get the i-th pair of AtomNumbers from the neighbor list
   std::pair<AtomNumber,AtomNumber> getClosePairAtomNumber(unsigned i) const;
 };
@@ -26,6 +26,7 @@
 #include "core/Value.h"
 #include "Communicator.h"
 #include "Tools.h"
+#include "AsyncWriter.h"
 #include <cstdarg>
 #include <cstring>
 
@@ -43,9 +44,43 @@
 
 namespace PLMD {
 
+/// Append raw bytes to a record of a binary file.
+/// Numbers are written with the native byte order, which is stored in the header
+static void appendBinary(std::string & record,const void*ptr,std::size_t n) {
+  record.append(static_cast<const char*>(ptr),n);
+}
+
+static void appendBinary(std::string & record,std::uint32_t x) {
+  appendBinary(record,&x,sizeof(x));
+}
+
+static void appendBinary(std::string & record,const std::string & str) {
+  appendBinary(record,std::uint32_t(str.length()));
+  record+=str;
+}
+
+/// Padding spaces are not needed in binary files
+static std::string trimBlanks(const std::string & str) {
+  std::size_t first=str.find_first_not_of(" \t");
+  if(first==std::string::npos) return "";
+  return str.substr(first,str.find_last_not_of(" \t")-first+1);
+}
+
+/// Size of the buffers passed to the background writer
+static const std::size_t asyncChunk=65536;
+
 size_t OFile::llwrite(const char*ptr,size_t s) {
   size_t r;
   if(linked) return linked->llwrite(ptr,s);
+// data are passed to the background writer in large chunks.
+// No communication is needed, since writes are not checked for success here
+  if(asyncWriter) {
+    if(! (comm && comm->Get_rank()>0)) {
+      asyncBuffer.append(ptr,s);
+      if(asyncBuffer.length()>=asyncChunk) submitAsync();
+    }
+    return s;
+  }
   if(! (comm && comm->Get_rank()>0)) {
     if(!fp) plumed_merror("writing on uninitialized File");
     if(gzfp) {
@@ -73,6 +108,7 @@ size_t OFile::llwrite(const char*ptr,size_t s) {
 
 OFile::OFile():
   linked(NULL),
+  asyncWriter(NULL),
   fieldChanged(false),
   backstring("bck"),
   enforceRestart_(false),
@@ -89,6 +125,28 @@ OFile::OFile():
   for(unsigned i=0; i<1000; ++i) buffer_string[i]=0;
 }
 
+OFile::~OFile() {
+// errors cannot be reported by a destructor
+  try {
+    waitAsync();
+  } catch(const std::exception & e) {
+    std::cerr<<"WARNING: "<<e.what()<<"\n";
+  }
+}
+
+void OFile::submitAsync() {
+  if(asyncBuffer.empty()) return;
+  std::string data;
+  std::swap(data,asyncBuffer);
+  asyncWriter->write(fp,gzfp,path,std::move(data));
+}
+
+void OFile::waitAsync() {
+  if(!asyncWriter) return;
+  submitAsync();
+  asyncWriter->wait();
+}
+
 OFile& OFile::link(OFile&l) {
   fp=NULL;
   gzfp=NULL;
@@ -128,8 +186,15 @@ int OFile::printf(const char*fmt,...) {
   char*psearch=p1+actual_buffer_length;
   actual_buffer_length+=r;
   while((p2=std::strchr(psearch,'\n'))) {
-    if(linePrefix.length()>0) llwrite(linePrefix.c_str(),linePrefix.length());
-    llwrite(p1,p2-p1+1);
+    if(binary) {
+// empty lines and comments (e.g. separators between blocks) are just dropped
+      const char*p=p1;
+      while(p<p2 && (*p==' ' || *p=='\t' || *p=='\r')) p++;
+      plumed_massert(p==p2 || *p=='#',"file " + getPath() + ": formatted text cannot be written on a binary file:\n" + std::string(p1,p2-p1));
+    } else {
+      if(linePrefix.length()>0) llwrite(linePrefix.c_str(),linePrefix.length());
+      llwrite(p1,p2-p1+1);
+    }
     actual_buffer_length-=(p2-p1)+1;
     p1=p2+1;
     psearch=p1;
@@ -168,7 +233,20 @@ OFile& OFile::printField(const std::string&name,double v) {
 // The distinction between +nan and -nan is not well defined
 // Always printing nan simplifies some regtest (special functions computed our of range).
   if(std::isnan(v)) v=std::numeric_limits<double>::quiet_NaN();
-  std::sprintf(buffer_string.get(),fieldFmt.c_str(),v);
+  if(binary) {
+    unsigned i;
+    for(i=0; i<const_fields.size(); i++) if(const_fields[i].name==name) break;
+    if(i>=const_fields.size()) {
+      Field field;
+      field.name=name;
+      field.isDouble=true;
+      field.dvalue=v;
+      fields.push_back(field);
+      return *this;
+    }
+// constants are stored as text in the header, with all the digits needed to read them back exactly
+    std::sprintf(buffer_string.get(),"%.17g",v);
+  } else std::sprintf(buffer_string.get(),fieldFmt.c_str(),v);
   printField(name,buffer_string.get());
   return *this;
 }
@@ -253,7 +331,10 @@ OFile& OFile::printField() {
         break;
       }
     }
-  if(reprint) {
+  if(binary) {
+    if(reprint) printBinaryHeader();
+    printBinaryFields();
+  } else if(reprint) {
     printf("#! FIELDS");
     for(unsigned i=0; i<fields.size(); i++) printf(" %s",fields[i].name.c_str());
     printf("\n");
@@ -262,14 +343,46 @@ OFile& OFile::printField() {
       printf("\n");
     }
   }
-  for(unsigned i=0; i<fields.size(); i++) printf("%s",fields[i].value.c_str());
-  printf("\n");
+  if(!binary) {
+    for(unsigned i=0; i<fields.size(); i++) printf("%s",fields[i].value.c_str());
+    printf("\n");
+  }
   previous_fields=fields;
   fields.clear();
   fieldChanged=false;
   return *this;
 }
 
+void OFile::printBinaryHeader() {
+  std::string record;
+  appendBinary(record,binaryMagic,sizeof(binaryMagic));
+  appendBinary(record,binaryVersion);
+  appendBinary(record,binaryByteOrder);
+  appendBinary(record,std::uint32_t(fields.size()));
+  for(const auto & f : fields) appendBinary(record,f.name);
+  appendBinary(record,std::uint32_t(const_fields.size()));
+  for(const auto & f : const_fields) {
+    appendBinary(record,f.name);
+    appendBinary(record,trimBlanks(f.value));
+  }
+  llwrite(record.data(),record.length());
+}
+
+void OFile::printBinaryFields() {
+// each value is preceded by its type, d (double) or s (string)
+  std::string record(1,'D');
+  for(const auto & f : fields) {
+    if(f.isDouble) {
+      record+='d';
+      appendBinary(record,&f.dvalue,sizeof(f.dvalue));
+    } else {
+      record+='s';
+      appendBinary(record,trimBlanks(f.value));
+    }
+  }
+  llwrite(record.data(),record.length());
+}
+
 void OFile::setBackupString( const std::string& str ) {
   backstring=str;
 }
@@ -325,6 +438,8 @@ OFile& OFile::open(const std::string&path) {
   gzfp=NULL;
   this->path=path;
   this->path=appendSuffix(path,getSuffix());
+  binary=(Tools::extension(this->path)=="pbin");
+  asyncWriter=(plumed ? plumed->getAsyncWriter() : NULL);
   if(checkRestart()) {
     fp=std::fopen(const_cast<char*>(this->path.c_str()),"a");
     mode="a";
@@ -348,6 +463,9 @@ OFile& OFile::open(const std::string&path) {
 #endif
     }
   }
+// in asynchronous mode writes are not synchronized, so we make sure that
+// no process truncates the file after process 0 has started writing on it
+  if(asyncWriter && comm) comm->Barrier();
   if(plumed) plumed->insertFile(*this);
   return *this;
 }
@@ -357,6 +475,7 @@ OFile& OFile::rewind() {
 // the reason is that normal rewind does not work when in append mode
 // moreover, we can take a backup of the file
   plumed_assert(fp);
+  waitAsync();
   clearFields();
   if(gzfp) {
 #ifdef __PLUMED_HAS_ZLIB
@@ -381,10 +500,19 @@ OFile& OFile::rewind() {
     gzfp=(void*)gzopen(const_cast<char*>(this->path.c_str()),"w9");
 #endif
   } else fp=std::fopen(const_cast<char*>(path.c_str()),"w");
+  if(asyncWriter && comm) comm->Barrier();
   return *this;
 }
 
 FileBase& OFile::flush() {
+// the file is flushed by the background writer after the queued data have been written.
+// Data are guaranteed to be on disk only after AsyncWriter::wait()
+  if(asyncWriter && !heavyFlush) {
+    submitAsync();
+    asyncWriter->flush(fp,gzfp,path);
+    return *this;
+  }
+  waitAsync();
   if(heavyFlush) {
     if(gzfp) {
 #ifdef __PLUMED_HAS_ZLIB
@@ -407,6 +535,12 @@ FileBase& OFile::flush() {
   return *this;
 }
 
+void OFile::close() {
+  waitAsync();
+  asyncWriter=NULL;
+  FileBase::close();
+}
+
 bool OFile::checkRestart()const {
   if(enforceRestart_) return true;
   else if(enforceBackup_) return false;
@@ -31,6 +31,7 @@
 namespace PLMD {
 
 class Value;
+class AsyncWriter;
 
 /**
 \ingroup TOOLBOX
@@ -79,6 +80,10 @@ keyword. Thus, everytime it is modified, all the headers are repeated in the out
 - printField() without arguments is used as a "newline".
 - most methods return a reference to the OFile itself, to allow chaining many calls on the same line
 (this is similar to << operator in std::ostream)
+- if the name of the file has extension pbin the fields are written in binary format.
+Doubles are then stored exactly and headers contain the same information as the
+"FIELDS" and "SET" lines. Empty lines and comments written with printf() are discarded,
+whereas any other formatted text is an error. IFile recognizes binary files automatically.
 
 \section using-correctly-ofile Using correctly OFile in PLUMED
 
@@ -164,9 +169,26 @@ class OFile:
 /// Class identifying a single field for fielded output
   class Field:
     public FieldBase {
+  public:
+/// In binary files doubles are stored as such, without formatting
+    bool isDouble;
+    double dvalue;
+    Field(): isDouble(false), dvalue(0.0) {}
   };
 /// Low-level write
   std::size_t llwrite(const char*,std::size_t);
+/// Write the header of a binary file
+  void printBinaryHeader();
+/// Write a line of fields in a binary file
+  void printBinaryFields();
+/// Writer used to write the file in background. NULL if the file is written synchronously
+  AsyncWriter* asyncWriter;
+/// Data waiting to be passed to asyncWriter
+  std::string asyncBuffer;
+/// Pass the buffered data to asyncWriter
+  void submitAsync();
+/// Wait until all the data have been written by asyncWriter
+  void waitAsync();
 /// True if fields has changed.
 /// This could be due to a change in the list of fields or a reset
 /// of a nominally constant field
@@ -196,6 +218,8 @@ class OFile:
 public:
 /// Constructor
   OFile();
+/// Destructor, completing asynchronous writes
+  ~OFile();
 /// Allows overloading of link
   using FileBase::link;
 /// Allows overloading of open
@@ -264,6 +288,8 @@ public:
   OFile&rewind();
 /// Flush a file
   FileBase&flush() override;
+/// Closes the file, completing asynchronous writes
+  void close() override;
 /// Enforce restart, also if the attached plumed object is not restarting.
 /// Useful for tests
   OFile&enforceRestart();
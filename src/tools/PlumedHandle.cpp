@@ -68,6 +68,13 @@ PlumedHandle::~PlumedHandle() {
   if(loaded) plumed_finalize(plumed_v2c(loaded));
 }
 
+PlumedHandle::PlumedHandle(PlumedHandle && other) noexcept:
+  local(std::move(other.local)),
+  loaded(other.loaded)
+{
+  other.loaded=nullptr;
+}
+
 PlumedHandle PlumedHandle::dlopen(const char* path) {
   return PlumedHandle(path);
 }
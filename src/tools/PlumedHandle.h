@@ -77,7 +77,8 @@ class PlumedHandle :
 /// Used when using the current kernel in order to avoid unneeded indirections.
   std::unique_ptr<PlumedMain> local;
 /// Pointer to loaded Plumed object;
-  void* const loaded=nullptr;
+/// Not const, so that it can be reset when the handle is moved.
+  void* loaded=nullptr;
 /// Constructor using the path to a kernel.
 /// I keep it private to avoid confusion wrt the
 /// similar constructor of PLMD::Plumed that accepts a string (conversion from FORTRAN).
@@ -94,7 +95,8 @@ public:
 /// I make it virtual for future extensibility, though this is not necessary now.
   virtual ~PlumedHandle();
 /// Move constructor.
-  PlumedHandle(PlumedHandle &&) = default;
+/// The moved-from handle is left empty, so that a loaded kernel is only finalized once.
+  PlumedHandle(PlumedHandle &&) noexcept;
 /// Execute cmd.
   void cmd(const std::string & key,const TypesafePtr & ptr=nullptr);
 /// Bring in the possibility to pass shape/nelem
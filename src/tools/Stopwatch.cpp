@@ -70,6 +70,71 @@ std::ostream& Stopwatch::log(std::ostream&os)const {
   return os;
 }
 
+void Stopwatch::setKeepLaps(bool keep) {
+  keepLaps=keep;
+  for(auto & w : watches) {
+    w.second.keepLaps=keep;
+    if(!keep) w.second.laps.clear();
+  }
+}
+
+std::ostream& Stopwatch::printStatistics(std::ostream&os,const std::string&format,long long int step,bool header) {
+  plumed_massert(format=="json" || format=="csv","unknown format "+format+" for timing statistics");
+  const bool json=(format=="json");
+  char buffer[1000];
+  buffer[0]=0;
+
+  if(!json && header) os<<"step,name,cycles,total,average,minimum,maximum,laps,p50,p90,p99,lapmax\n";
+
+  std::vector<std::string> names;
+  for(const auto & it : watches) names.push_back(it.first);
+  std::sort(names.begin(),names.end());
+
+  const double frac=1.0/1000000000.0;
+
+  std::vector<long long int> sorted;
+  for(const auto & name : names) {
+    Watch&t(watches.find(name)->second);
+// names might contain characters that should be escaped, e.g. quotes
+    std::string escaped;
+    for(const auto c : name) {
+      if(c=='"' || (json && c=='\\')) escaped+=(json?'\\':'"');
+      escaped+=c;
+    }
+    const double average=(t.cycles>0?frac*t.total/t.cycles:0.0);
+    if(json) std::sprintf(buffer,"{\"step\":%lld,\"name\":\"%s\",\"cycles\":%u,\"total\":%.9f,\"average\":%.9f,\"minimum\":%.9f,\"maximum\":%.9f,\"laps\":%u",
+                            step,escaped.c_str(),t.cycles,frac*t.total,average,frac*t.min,frac*t.max,(unsigned)t.laps.size());
+    else std::sprintf(buffer,"%lld,\"%s\",%u,%.9f,%.9f,%.9f,%.9f,%u",
+                        step,escaped.c_str(),t.cycles,frac*t.total,average,frac*t.min,frac*t.max,(unsigned)t.laps.size());
+    os<<buffer;
+// percentiles are computed with the nearest-rank method on the laps completed since the last call
+    sorted=t.laps;
+    std::sort(sorted.begin(),sorted.end());
+    const unsigned n=sorted.size();
+    const unsigned percentiles[3]= {50,90,99};
+    for(unsigned i=0; i<3; i++) {
+      if(json) os<<",\"p"<<percentiles[i]<<"\":";
+      else os<<",";
+      if(n>0) {
+        unsigned rank=(percentiles[i]*n+99)/100;
+        if(rank<1) rank=1;
+        std::sprintf(buffer,"%.9f",frac*sorted[rank-1]);
+        os<<buffer;
+      } else if(json) os<<"null";
+    }
+    if(json) os<<",\"lapmax\":";
+    else os<<",";
+    if(n>0) {
+      std::sprintf(buffer,"%.9f",frac*sorted[n-1]);
+      os<<buffer;
+    } else if(json) os<<"null";
+    if(json) os<<"}";
+    os<<"\n";
+    t.laps.clear();
+  }
+  return os;
+}
+
 }
 
 
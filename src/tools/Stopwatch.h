@@ -27,6 +27,7 @@
 #include <unordered_map>
 #include <iosfwd>
 #include <chrono>
+#include <vector>
 
 namespace PLMD {
 
@@ -161,6 +162,12 @@ Finally, notice that in order to write the timers on an output file when the
 Stopwatch is destroyed, one can store a reference to a PLMD::Log by passing it
 to the Stopwatch constructor.
 This will make sure timers are written also in case of a premature end.
+
+Calling Stopwatch::setKeepLaps() makes all the watches remember the duration of each
+of their cycles. Statistics on these cycles (including percentiles) can then be written
+in a machine readable format (JSON lines or CSV) with Stopwatch::printStatistics().
+The list of remembered cycles is cleared every time statistics are printed, so that
+percentiles refer to the cycles completed since the previous call.
 */
 
 class Log;
@@ -226,6 +233,10 @@ public:
     enum class State {started, stopped, paused};
 /// keep track of state
     State state = State::stopped;
+/// If true, the duration of each lap is stored in laps
+    bool keepLaps = false;
+/// Durations of the laps completed since the last call to Stopwatch::printStatistics(), in nanoseconds
+    std::vector<long long int> laps;
 /// Allows access to internal data
     friend class Stopwatch;
   public:
@@ -251,9 +262,15 @@ private:
 /// Each watch is labeled with a string.
   std::unordered_map<std::string,Watch> watches;
 
+/// If true, newly created watches keep track of their laps
+  bool keepLaps=false;
+
 /// Log over stream os.
   std::ostream& log(std::ostream& os)const;
 
+/// Get watch named "name", creating it if needed
+  Watch& getWatch(const std::string&name);
+
 public:
 // Constructor.
   explicit Stopwatch() = default;
@@ -282,8 +299,32 @@ public:
 /// pauses the watch. This allows Stopwatch to be started and paused in
 /// an exception safe manner.
   Handler startPause(const std::string&name=StopwatchEmptyString());
+/// Total time accumulated by timer named "name", in nanoseconds
+  long long int getTotal(const std::string&name=StopwatchEmptyString())const;
+/// Switch on/off storage of the duration of each lap, for all the watches
+  void setKeepLaps(bool keep);
+/// Print statistics about all the watches on stream os.
+/// format can be "json" (one JSON object per watch and per line) or "csv".
+/// Percentiles are computed on the laps completed since the previous call, which are then cleared.
+/// step is written together with the statistics.
+/// If header is true and format is "csv", a line with the names of the columns is written first.
+  std::ostream& printStatistics(std::ostream& os,const std::string&format,long long int step,bool header=false);
 };
 
+inline
+long long int Stopwatch::getTotal(const std::string & name)const {
+  const auto it=watches.find(name);
+  plumed_massert(it!=watches.end(),"timer "+name+" does not exist");
+  return it->second.total;
+}
+
+inline
+Stopwatch::Watch& Stopwatch::getWatch(const std::string & name) {
+  auto & w=watches[name];
+  if(keepLaps) w.keepLaps=true;
+  return w;
+}
+
 inline
 Stopwatch::Handler::Handler(Watch* watch,bool stop) :
   watch(watch),
@@ -302,30 +343,30 @@ Stopwatch::Handler::~Handler() {
 
 inline
 Stopwatch& Stopwatch::start(const std::string & name) {
-  watches[name].start();
+  getWatch(name).start();
   return *this;
 }
 
 inline
 Stopwatch& Stopwatch::stop(const std::string & name) {
-  watches[name].stop();
+  getWatch(name).stop();
   return *this;
 }
 
 inline
 Stopwatch& Stopwatch::pause(const std::string & name) {
-  watches[name].pause();
+  getWatch(name).pause();
   return *this;
 }
 
 inline
 Stopwatch::Handler Stopwatch::startStop(const std::string&name) {
-  return watches[name].startStop();
+  return getWatch(name).startStop();
 }
 
 inline
 Stopwatch::Handler Stopwatch::startPause(const std::string&name) {
-  return watches[name].startPause();
+  return getWatch(name).startPause();
 }
 
 inline
@@ -372,6 +413,7 @@ Stopwatch::Watch & Stopwatch::Watch::stop() {
   total+=lap;
   if(lap>max)max=lap;
   if(min>lap || cycles==1)min=lap;
+  if(keepLaps) laps.push_back(lap);
   lap=0;
   return *this;
 }
@@ -110,6 +110,11 @@ public:
 /// The advantage is that in some case the expensive square root can be avoided
 /// (namely for rational functions, if nn and mm are even and d0 is zero)
   double calculateSqr(double distance2,double&dfunc)const;
+/// Compute the switching function on an array of n squared distances.
+/// Values and derivatives are stored in value and dfunc, that should be of size n.
+/// Results are the same as those of calculateSqr(), but specialized loops
+/// are used for rational, exponential and gaussian functions.
+  void calculateSqr(const double* distance2,double* value,double* dfunc,unsigned n)const;
 /// Returns d0
   double get_d0() const;
 /// Returns r0
@@ -152,7 +152,7 @@ void BF_Combined::getAllValues(const double arg, double& argT, bool& inside_rang
   unsigned int r=0;
   std::vector<double> values_tmp(basisf_pntrs_[0]->numberOfBasisFunctions(),0.0);
   std::vector<double> derivs_tmp(basisf_pntrs_[0]->numberOfBasisFunctions(),0.0);
-  basisf_pntrs_[0]->getAllValues(arg,argT,inside_range,values_tmp,derivs_tmp);
+  basisf_pntrs_[0]->evaluateAllValues(arg,argT,inside_range,values_tmp,derivs_tmp);
   for(unsigned int l=0; l<basisf_pntrs_[0]->numberOfBasisFunctions(); l++) {
     values[r] = values_tmp[l];
     derivs[r] = derivs_tmp[l];
@@ -163,7 +163,7 @@ void BF_Combined::getAllValues(const double arg, double& argT, bool& inside_rang
     values_tmp.assign(basisf_pntrs_[i]->numberOfBasisFunctions(),0.0);
     derivs_tmp.assign(basisf_pntrs_[i]->numberOfBasisFunctions(),0.0);
     double dummy_dbl; bool dummy_bool=true;
-    basisf_pntrs_[i]->getAllValues(arg,dummy_dbl,dummy_bool,values_tmp,derivs_tmp);
+    basisf_pntrs_[i]->evaluateAllValues(arg,dummy_dbl,dummy_bool,values_tmp,derivs_tmp);
     for(unsigned int l=1; l<basisf_pntrs_[i]->numberOfBasisFunctions(); l++) {
       values[r] = values_tmp[l];
       derivs[r] = derivs_tmp[l];
@@ -29,6 +29,8 @@
 #include "tools/Grid.h"
 #include "tools/Tools.h"
 
+#include <algorithm>
+
 
 namespace PLMD {
 namespace ves {
@@ -41,6 +43,7 @@ void BasisFunctions::registerKeywords(Keywords& keys) {
   keys.add("hidden","NGRID_POINTS","The number of grid points used for numerical integrals");
   keys.addFlag("DEBUG_INFO",false,"Print out more detailed information about the basis set. Useful for debugging.");
   keys.addFlag("NUMERICAL_INTEGRALS",false,"Calculate basis function integral for the uniform distribution numerically. Useful for debugging.");
+  keys.add("optional","TABULATE","Tabulate the values and derivatives of the basis functions on this number of equally spaced points in the interval, and calculate them by cubic Hermite interpolation. This makes basis functions that are expensive to calculate faster, at the price of an interpolation error that is written in the log.");
 }
 
 
@@ -72,6 +75,8 @@ BasisFunctions::BasisFunctions(const ActionOptions&ao):
   numerical_uniform_integrals_(false),
   nbins_(1001),
   uniform_integrals_(nbasis_,0.0),
+  ntabulate_(0),
+  tabulate_spacing_(0.0),
   vesbias_pntr_(NULL),
   action_pntr_(NULL)
 {
@@ -107,6 +112,10 @@ BasisFunctions::BasisFunctions(const ActionOptions&ao):
   if(keywords.exists("NGRID_POINTS")) {
     parse("NGRID_POINTS",nbins_);
   }
+  if(keywords.exists("TABULATE")) {
+    parse("TABULATE",ntabulate_);
+    if(ntabulate_==1) {plumed_merror(getName()+": at least two points are needed in TABULATE");}
+  }
   // log.printf(" %s \n",getKeywordString().c_str());
 
 }
@@ -192,6 +201,45 @@ void BasisFunctions::setupBF() {
   if(description_=="Undefined") {plumed_merror("setupBF: the description of the basis function is not defined.");}
   has_been_set=true;
   printInfo();
+  if(ntabulate_>0) {setupTabulation();}
+}
+
+
+void BasisFunctions::setupTabulation() {
+  tabulate_spacing_ = interval_range_/(ntabulate_-1);
+  tabulated_values_.assign(ntabulate_*nbasis_,0.0);
+  tabulated_derivs_.assign(ntabulate_*nbasis_,0.0);
+  tabulated_argT_.assign(ntabulate_,0.0);
+  std::vector<double> values(nbasis_);
+  std::vector<double> derivs(nbasis_);
+  for(unsigned int k=0; k<ntabulate_; k++) {
+    double arg = interval_min_+k*tabulate_spacing_;
+    if(k==ntabulate_-1) {arg=interval_max_;}
+    bool inside=true;
+    getAllValues(arg,tabulated_argT_[k],inside,values,derivs);
+    for(unsigned int i=0; i<nbasis_; i++) {
+      tabulated_values_[k*nbasis_+i]=values[i];
+      tabulated_derivs_[k*nbasis_+i]=derivs[i];
+    }
+  }
+  // the interpolation error is largest in the middle between the grid points
+  double max_error_values=0.0;
+  double max_error_derivs=0.0;
+  std::vector<double> values_tab(nbasis_);
+  std::vector<double> derivs_tab(nbasis_);
+  for(unsigned int k=0; k<ntabulate_-1; k++) {
+    double arg = interval_min_+(k+0.5)*tabulate_spacing_;
+    double argT; bool inside=true;
+    getAllValues(arg,argT,inside,values,derivs);
+    evaluateAllValues(arg,argT,inside,values_tab,derivs_tab);
+    for(unsigned int i=0; i<nbasis_; i++) {
+      max_error_values=std::max(max_error_values,std::abs(values_tab[i]-values[i]));
+      max_error_derivs=std::max(max_error_derivs,std::abs(derivs_tab[i]-derivs[i]));
+    }
+  }
+  log.printf("  Basis functions are tabulated on %u points and interpolated\n",ntabulate_);
+  log.printf("   maximum interpolation error for the values: %e\n",max_error_values);
+  log.printf("   maximum interpolation error for the derivatives: %e\n",max_error_derivs);
 }
 
 
@@ -333,7 +381,7 @@ void BasisFunctions::getMultipleValue(const std::vector<double>& args, std::vect
     std::vector<double> tmp_derivs(getNumberOfBasisFunctions());
     bool inside_interval=true;
     if(!numerical_deriv) {
-      getAllValues(args[i],argsT[i],inside_interval,tmp_values,tmp_derivs);
+      evaluateAllValues(args[i],argsT[i],inside_interval,tmp_values,tmp_derivs);
     } else {
       getAllValuesNumericalDerivs(args[i],argsT[i],inside_interval,tmp_values,tmp_derivs);
     }
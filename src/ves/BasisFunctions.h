@@ -93,11 +93,19 @@ private:
   unsigned int nbins_;
   // the integrals of the basis functions over the interval on which they are defined
   std::vector <double> uniform_integrals_;
+  // number of grid points on which the basis functions are tabulated (zero if they are not tabulated)
+  unsigned int ntabulate_;
+  double tabulate_spacing_;
+  // values, derivatives and translated arguments on the tabulation grid
+  std::vector<double> tabulated_values_;
+  std::vector<double> tabulated_derivs_;
+  std::vector<double> tabulated_argT_;
   //
   VesBias* vesbias_pntr_;
   Action* action_pntr_;
   //
   void getAllValuesNumericalDerivs(const double, double&, bool&, std::vector<double>&, std::vector<double>&) const;
+  void setupTabulation();
 
 protected:
   // setup various stuff
@@ -183,6 +191,9 @@ public:
   double getValue(const double, const unsigned int, double&, bool&) const;
   // calculate the values for all basis functions
   virtual void getAllValues(const double, double&, bool&, std::vector<double>&, std::vector<double>&) const = 0;
+  // calculate the values for all basis functions, interpolating them if they are tabulated
+  void evaluateAllValues(const double, double&, bool&, std::vector<double>&, std::vector<double>&) const;
+  bool isTabulated() const {return ntabulate_>0;}
   //virtual void get2ndDerivatives(const double, std::vector<double>&)=0;
   void printInfo() const;
   //
@@ -283,6 +294,41 @@ double BasisFunctions::checkIfArgumentInsideInterval(const double arg, bool& ins
 
 
 
+inline
+void BasisFunctions::evaluateAllValues(const double arg, double& argT, bool& inside_range, std::vector<double>& values, std::vector<double>& derivs) const {
+  // written so that non-finite arguments are also calculated analytically
+  if(ntabulate_==0 || !(arg>=interval_min_ && arg<=interval_max_)) {
+    getAllValues(arg,argT,inside_range,values,derivs);
+    return;
+  }
+  inside_range=true;
+  // cubic Hermite interpolation using the tabulated values and derivatives
+  double x = (arg-interval_min_)/tabulate_spacing_;
+  unsigned int k = static_cast<unsigned int>(x);
+  if(k>ntabulate_-2) {k=ntabulate_-2;}
+  double t = x-k;
+  double t2 = t*t;
+  double t3 = t2*t;
+  double h00 = 2.0*t3-3.0*t2+1.0;
+  double h10 = (t3-2.0*t2+t)*tabulate_spacing_;
+  double h01 = 3.0*t2-2.0*t3;
+  double h11 = (t3-t2)*tabulate_spacing_;
+  double d00 = (6.0*t2-6.0*t)/tabulate_spacing_;
+  double d10 = 3.0*t2-4.0*t+1.0;
+  double d01 = -d00;
+  double d11 = 3.0*t2-2.0*t;
+  argT = (1.0-t)*tabulated_argT_[k]+t*tabulated_argT_[k+1];
+  const double* v0 = &tabulated_values_[k*nbasis_];
+  const double* v1 = v0+nbasis_;
+  const double* g0 = &tabulated_derivs_[k*nbasis_];
+  const double* g1 = g0+nbasis_;
+  for(unsigned int i=0; i<nbasis_; i++) {
+    values[i] = h00*v0[i]+h10*g0[i]+h01*v1[i]+h11*g1[i];
+    derivs[i] = d00*v0[i]+d10*g0[i]+d01*v1[i]+d11*g1[i];
+  }
+}
+
+
 template<typename T>
 void BasisFunctions::addKeywordToList(const std::string& keyword, const T value) {
   std::string str_value;
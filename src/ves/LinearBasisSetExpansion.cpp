@@ -32,6 +32,7 @@
 #include "tools/Keywords.h"
 #include "tools/Grid.h"
 #include "tools/Communicator.h"
+#include "tools/OpenMP.h"
 
 #include "GridProjWeights.h"
 
@@ -177,24 +178,7 @@ void LinearBasisSetExpansion::updateBiasGrid() {
   if(action_pntr_!=NULL &&  getStepOfLastBiasGridUpdate()==action_pntr_->getStep()) {
     return;
   }
-  for(Grid::index_t l=0; l<bias_grid_pntr_->getSize(); l++) {
-    std::vector<double> forces(nargs_);
-    std::vector<double> args = bias_grid_pntr_->getPoint(l);
-    bool all_inside=true;
-    double bias=getBiasAndForces(args,all_inside,forces);
-    //
-    if(biasCutoffActive()) {
-      vesbias_pntr_->applyBiasCutoff(bias,forces);
-    }
-    //
-    if(bias_grid_pntr_->hasDerivatives()) {
-      bias_grid_pntr_->setValueAndDerivatives(l,bias,forces);
-    }
-    else {
-      bias_grid_pntr_->setValue(l,bias);
-    }
-    //
-  }
+  calculateBiasOnGrid(bias_grid_pntr_.get(),biasCutoffActive());
   if(vesbias_pntr_!=NULL) {
     vesbias_pntr_->setCurrentBiasMaxValue(bias_grid_pntr_->getMaxValue());
   }
@@ -212,18 +196,7 @@ void LinearBasisSetExpansion::updateBiasWithoutCutoffGrid() {
     return;
   }
   //
-  for(Grid::index_t l=0; l<bias_withoutcutoff_grid_pntr_->getSize(); l++) {
-    std::vector<double> forces(nargs_);
-    std::vector<double> args = bias_withoutcutoff_grid_pntr_->getPoint(l);
-    bool all_inside=true;
-    double bias=getBiasAndForces(args,all_inside,forces);
-    if(bias_withoutcutoff_grid_pntr_->hasDerivatives()) {
-      bias_withoutcutoff_grid_pntr_->setValueAndDerivatives(l,bias,forces);
-    }
-    else {
-      bias_withoutcutoff_grid_pntr_->setValue(l,bias);
-    }
-  }
+  calculateBiasOnGrid(bias_withoutcutoff_grid_pntr_.get(),false);
   //
   double bias_max = bias_withoutcutoff_grid_pntr_->getMaxValue();
   double bias_min = bias_withoutcutoff_grid_pntr_->getMinValue();
@@ -263,6 +236,110 @@ void LinearBasisSetExpansion::updateBiasWithoutCutoffGrid() {
 }
 
 
+void LinearBasisSetExpansion::getBasisFunctionsOnGridAxes(const Grid* grid_pntr, std::vector< std::vector< std::vector<double> > >& bf_values, std::vector< std::vector< std::vector<double> > >& bf_derivs) const {
+  // the points of the grid along each argument are few, so the basis functions
+  // are evaluated here once and then only looked up in the (threaded) loops over the grid
+  std::vector<unsigned int> npoints = grid_pntr->getNbin();
+  bf_values.assign(nargs_,std::vector< std::vector<double> >(0));
+  bf_derivs.assign(nargs_,std::vector< std::vector<double> >(0));
+  for(unsigned int k=0; k<nargs_; k++) {
+    std::vector<unsigned int> indices(nargs_,0);
+    for(unsigned int p=0; p<npoints[k]; p++) {
+      indices[k]=p;
+      std::vector<double> args = grid_pntr->getPoint(indices);
+      std::vector<double> values(nbasisf_[k]);
+      std::vector<double> derivs(nbasisf_[k]);
+      double argT;
+      bool inside=true;
+      basisf_pntrs_[k]->evaluateAllValues(args[k],argT,inside,values,derivs);
+      bf_values[k].push_back(values);
+      bf_derivs[k].push_back(derivs);
+    }
+  }
+}
+
+
+std::vector<unsigned int> LinearBasisSetExpansion::getAllCoeffsIndices() const {
+  std::vector<unsigned int> all_indices(ncoeffs_*nargs_);
+  for(size_t i=0; i<ncoeffs_; i++) {
+    std::vector<unsigned int> indices=bias_coeffs_pntr_->getIndices(i);
+    for(unsigned int k=0; k<nargs_; k++) {
+      all_indices[i*nargs_+k]=indices[k];
+    }
+  }
+  return all_indices;
+}
+
+
+void LinearBasisSetExpansion::calculateBiasOnGrid(Grid* grid_pntr, const bool apply_bias_cutoff) const {
+  std::vector< std::vector< std::vector<double> > > bf_values;
+  std::vector< std::vector< std::vector<double> > > bf_derivs;
+  getBasisFunctionsOnGridAxes(grid_pntr,bf_values,bf_derivs);
+  std::vector<unsigned int> coeffs_indices = getAllCoeffsIndices();
+  //
+  // each grid point is done by a single thread of a single rank, so the result
+  // does not depend on the number of ranks and threads
+  Grid::index_t npoints = grid_pntr->getSize();
+  bool with_derivs = grid_pntr->hasDerivatives();
+  std::vector<double> grid_values(npoints,0.0);
+  std::vector<double> grid_derivs(with_derivs ? npoints*nargs_ : 0,0.0);
+  Grid::index_t stride=mycomm_.Get_size();
+  Grid::index_t rank=mycomm_.Get_rank();
+  #pragma omp parallel num_threads(OpenMP::getNumThreads())
+  {
+    std::vector<unsigned int> indices(nargs_);
+    std::vector<double> forces(nargs_);
+    #pragma omp for schedule(static)
+    for(Grid::index_t l=rank; l<npoints; l+=stride) {
+      grid_pntr->getIndices(l,indices);
+      double bias=0.0;
+      for(unsigned int k=0; k<nargs_; k++) {forces[k]=0.0;}
+      for(size_t i=0; i<ncoeffs_; i++) {
+        const unsigned int* cindices = &coeffs_indices[i*nargs_];
+        double coeff = bias_coeffs_pntr_->getValue(i);
+        double bf_curr=1.0;
+        for(unsigned int k=0; k<nargs_; k++) {
+          bf_curr*=bf_values[k][indices[k]][cindices[k]];
+        }
+        bias+=coeff*bf_curr;
+        for(unsigned int k=0; k<nargs_; k++) {
+          double der = 1.0;
+          for(unsigned int m=0; m<nargs_; m++) {
+            if(m!=k) {der*=bf_values[m][indices[m]][cindices[m]];}
+            else {der*=bf_derivs[m][indices[m]][cindices[m]];}
+          }
+          forces[k]-=coeff*der;
+        }
+      }
+      //
+      if(apply_bias_cutoff) {
+        vesbias_pntr_->applyBiasCutoff(bias,forces);
+      }
+      //
+      grid_values[l]=bias;
+      if(with_derivs) {
+        for(unsigned int k=0; k<nargs_; k++) {grid_derivs[l*nargs_+k]=forces[k];}
+      }
+    }
+  }
+  mycomm_.Sum(grid_values);
+  if(with_derivs) {
+    mycomm_.Sum(grid_derivs);
+  }
+  //
+  std::vector<double> forces(nargs_);
+  for(Grid::index_t l=0; l<npoints; l++) {
+    if(with_derivs) {
+      for(unsigned int k=0; k<nargs_; k++) {forces[k]=grid_derivs[l*nargs_+k];}
+      grid_pntr->setValueAndDerivatives(l,grid_values[l],forces);
+    }
+    else {
+      grid_pntr->setValue(l,grid_values[l]);
+    }
+  }
+}
+
+
 void LinearBasisSetExpansion::updateFesGrid() {
   plumed_massert(fes_grid_pntr_,"the FES grid is not defined");
   updateBiasGrid();
@@ -271,6 +348,7 @@ void LinearBasisSetExpansion::updateFesGrid() {
   }
   //
   double bias2fes_scalingf = -1.0;
+  #pragma omp parallel for num_threads(OpenMP::getNumThreads())
   for(Grid::index_t l=0; l<fes_grid_pntr_->getSize(); l++) {
     double fes_value = bias2fes_scalingf*bias_grid_pntr_->getValue(l);
     if(log_targetdist_grid_pntr_!=NULL) {
@@ -370,7 +448,7 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
     bf_values[k].assign(basisf_pntrs_in[k]->getNumberOfBasisFunctions(),0.0);
     bf_derivs[k].assign(basisf_pntrs_in[k]->getNumberOfBasisFunctions(),0.0);
     bool curr_inside=true;
-    basisf_pntrs_in[k]->getAllValues(args_values[k],args_values_trsfrm[k],curr_inside,bf_values[k],bf_derivs[k]);
+    basisf_pntrs_in[k]->evaluateAllValues(args_values[k],args_values_trsfrm[k],curr_inside,bf_values[k],bf_derivs[k]);
     // inside_interval[k]=curr_inside;
     if(!curr_inside) {all_inside=false;}
     forces[k]=0.0;
@@ -383,27 +461,42 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
     stride=comm_in->Get_size();
     rank=comm_in->Get_rank();
   }
-  // loop over coeffs
-  double bias=0.0;
-  for(size_t i=rank; i<coeffs_pntr_in->numberOfCoeffs(); i+=stride) {
-    std::vector<unsigned int> indices=coeffs_pntr_in->getIndices(i);
-    double coeff = coeffs_pntr_in->getValue(i);
-    double bf_curr=1.0;
-    for(unsigned int k=0; k<nargs; k++) {
-      bf_curr*=bf_values[k][indices[k]];
-    }
-    bias+=coeff*bf_curr;
-    coeffsderivs_values[i] = bf_curr;
-    for(unsigned int k=0; k<nargs; k++) {
-      double der = 1.0;
-      for(unsigned int l=0; l<nargs; l++) {
-        if(l!=k) {der*=bf_values[l][indices[l]];}
-        else {der*=bf_derivs[l][indices[l]];}
+  // loop over coeffs, each thread keeps its own partial sums that are then added in a fixed order
+  unsigned nt=OpenMP::getGoodNumThreads(coeffsderivs_values);
+  std::vector<double> thread_sums(nt*(nargs+1),0.0);
+  #pragma omp parallel num_threads(nt)
+  {
+    double bias_t=0.0;
+    std::vector<double> forces_t(nargs,0.0);
+    #pragma omp for schedule(static)
+    for(size_t i=rank; i<coeffs_pntr_in->numberOfCoeffs(); i+=stride) {
+      std::vector<unsigned int> indices=coeffs_pntr_in->getIndices(i);
+      double coeff = coeffs_pntr_in->getValue(i);
+      double bf_curr=1.0;
+      for(unsigned int k=0; k<nargs; k++) {
+        bf_curr*=bf_values[k][indices[k]];
+      }
+      bias_t+=coeff*bf_curr;
+      coeffsderivs_values[i] = bf_curr;
+      for(unsigned int k=0; k<nargs; k++) {
+        double der = 1.0;
+        for(unsigned int l=0; l<nargs; l++) {
+          if(l!=k) {der*=bf_values[l][indices[l]];}
+          else {der*=bf_derivs[l][indices[l]];}
+        }
+        forces_t[k]-=coeff*der;
+        // maybe faster but dangerous
+        // forces_t[k]-=coeff*bf_curr*(bf_derivs[k][indices[k]]/bf_values[k][indices[k]]);
       }
-      forces[k]-=coeff*der;
-      // maybe faster but dangerous
-      // forces[k]-=coeff*bf_curr*(bf_derivs[k][indices[k]]/bf_values[k][indices[k]]);
     }
+    unsigned t=OpenMP::getThreadNum();
+    thread_sums[t*(nargs+1)]=bias_t;
+    for(unsigned int k=0; k<nargs; k++) {thread_sums[t*(nargs+1)+1+k]=forces_t[k];}
+  }
+  double bias=0.0;
+  for(unsigned t=0; t<nt; t++) {
+    bias+=thread_sums[t*(nargs+1)];
+    for(unsigned int k=0; k<nargs; k++) {forces[k]+=thread_sums[t*(nargs+1)+1+k];}
   }
   //
   if(comm_in!=NULL) {
@@ -427,7 +520,7 @@ void LinearBasisSetExpansion::getBasisSetValues(const std::vector<double>& args_
     std::vector<double> tmp_val(basisf_pntrs_in[k]->getNumberOfBasisFunctions());
     std::vector<double> tmp_der(tmp_val.size());
     bool inside=true;
-    basisf_pntrs_in[k]->getAllValues(args_values[k],args_values_trsfrm[k],inside,tmp_val,tmp_der);
+    basisf_pntrs_in[k]->evaluateAllValues(args_values[k],args_values_trsfrm[k],inside,tmp_val,tmp_der);
     bf_values.push_back(tmp_val);
   }
   //
@@ -466,7 +559,7 @@ double LinearBasisSetExpansion::getBasisSetValue(const std::vector<double>& args
     std::vector<double> tmp_val(basisf_pntrs_in[k]->getNumberOfBasisFunctions());
     std::vector<double> tmp_der(tmp_val.size());
     bool inside=true;
-    basisf_pntrs_in[k]->getAllValues(args_values[k],args_values_trsfrm[k],inside,tmp_val,tmp_der);
+    basisf_pntrs_in[k]->evaluateAllValues(args_values[k],args_values_trsfrm[k],inside,tmp_val,tmp_der);
     bf_values.push_back(tmp_val);
   }
   //
@@ -487,6 +580,7 @@ void LinearBasisSetExpansion::setupUniformTargetDistribution() {
     bf_integrals.push_back(basisf_pntrs_[k]->getUniformIntegrals());
   }
   //
+  #pragma omp parallel for num_threads(OpenMP::getNumThreads())
   for(size_t i=0; i<ncoeffs_; i++) {
     std::vector<unsigned int> indices=bias_coeffs_pntr_->getIndices(i);
     double value = 1.0;
@@ -557,16 +651,40 @@ void LinearBasisSetExpansion::calculateTargetDistAveragesFromGrid(const Grid* ta
   plumed_assert(targetdist_grid_pntr!=NULL);
   std::vector<double> targetdist_averages(ncoeffs_,0.0);
   std::vector<double> integration_weights = GridIntegrationWeights::getIntegrationWeights(targetdist_grid_pntr);
+  std::vector< std::vector< std::vector<double> > > bf_values;
+  std::vector< std::vector< std::vector<double> > > bf_derivs;
+  getBasisFunctionsOnGridAxes(targetdist_grid_pntr,bf_values,bf_derivs);
+  std::vector<unsigned int> coeffs_indices = getAllCoeffsIndices();
+  //
+  // each thread sums over its own grid points, and the partial sums are then
+  // added in a fixed order so that the result is reproducible
+  unsigned nt=OpenMP::getNumThreads();
+  std::vector< std::vector<double> > thread_averages(nt);
   Grid::index_t stride=mycomm_.Get_size();
   Grid::index_t rank=mycomm_.Get_rank();
-  for(Grid::index_t l=rank; l<targetdist_grid_pntr->getSize(); l+=stride) {
-    std::vector<double> args_values = targetdist_grid_pntr->getPoint(l);
-    std::vector<double> basisset_values(ncoeffs_);
-    // parallelization done over the grid -> should NOT use parallel in getBasisSetValues!!
-    getBasisSetValues(args_values,basisset_values,false);
-    double weight = integration_weights[l]*targetdist_grid_pntr->getValue(l);
-    for(unsigned int i=0; i<ncoeffs_; i++) {
-      targetdist_averages[i] += weight*basisset_values[i];
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<double>& my_averages = thread_averages[OpenMP::getThreadNum()];
+    my_averages.assign(ncoeffs_,0.0);
+    std::vector<unsigned int> indices(nargs_);
+    #pragma omp for schedule(static)
+    for(Grid::index_t l=rank; l<targetdist_grid_pntr->getSize(); l+=stride) {
+      targetdist_grid_pntr->getIndices(l,indices);
+      double weight = integration_weights[l]*targetdist_grid_pntr->getValue(l);
+      for(size_t i=0; i<ncoeffs_; i++) {
+        const unsigned int* cindices = &coeffs_indices[i*nargs_];
+        double bf_curr=1.0;
+        for(unsigned int k=0; k<nargs_; k++) {
+          bf_curr*=bf_values[k][indices[k]][cindices[k]];
+        }
+        my_averages[i] += weight*bf_curr;
+      }
+    }
+  }
+  for(unsigned t=0; t<nt; t++) {
+    if(thread_averages[t].size()==0) {continue;}
+    for(size_t i=0; i<ncoeffs_; i++) {
+      targetdist_averages[i] += thread_averages[t][i];
     }
   }
   mycomm_.Sum(targetdist_averages);
@@ -188,6 +188,11 @@ private:
   std::unique_ptr<Grid> setupGeneralGrid(const std::string&, const bool usederiv=false);
   //
   void calculateTargetDistAveragesFromGrid(const Grid*);
+  // values and derivatives of the basis functions at the grid points along each argument
+  void getBasisFunctionsOnGridAxes(const Grid*, std::vector< std::vector< std::vector<double> > >&, std::vector< std::vector< std::vector<double> > >&) const;
+  // indices of all the coefficients, stored contiguously
+  std::vector<unsigned int> getAllCoeffsIndices() const;
+  void calculateBiasOnGrid(Grid*, const bool) const;
   //
   bool isStaticTargetDistFileOutputActive() const;
 };
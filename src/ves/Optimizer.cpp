@@ -51,6 +51,9 @@ Optimizer::Optimizer(const ActionOptions&ao):
   monitor_instantaneous_gradient_(false),
   use_mwalkers_mpi_(false),
   mwalkers_mpi_single_files_(true),
+  packed_comm_(false),
+  async_comm_(false),
+  async_comm_pending_(false),
   dynamic_targetdists_(0),
   ustride_targetdist_(0),
   ustride_reweightfactor_(0),
@@ -221,6 +224,23 @@ Optimizer::Optimizer(const ActionOptions&ao):
     log << plumed.cite("Raiteri, Laio, Gervasio, Micheletti, and Parrinello, J. Phys. Chem. B 110, 3533 (2006)");
     log.printf("\n");
   }
+  if(keywords.exists("PACKED_COMMUNICATION")) {
+    parseFlag("PACKED_COMMUNICATION",packed_comm_);
+  }
+  if(keywords.exists("ASYNC_COMMUNICATION")) {
+    parseFlag("ASYNC_COMMUNICATION",async_comm_);
+    if(async_comm_ && !use_mwalkers_mpi_) {
+      plumed_merror("using the ASYNC_COMMUNICATION keyword only makes sense with multiple walkers (MULTIPLE_WALKERS keyword)");
+    }
+    if(async_comm_) {packed_comm_=true;}
+  }
+  if(packed_comm_) {
+    log.printf("  the sampled averages of all coefficient sets are summed with a single collective operation\n");
+  }
+  if(async_comm_) {
+    log.printf("  the sampled averages are summed among walkers while the simulation continues,\n");
+    log.printf("   coefficients are thus updated using the averages sampled in the previous iteration\n");
+  }
 
   dynamic_targetdists_.resize(nbiases_,false);
   if(keywords.exists("TARGETDIST_STRIDE")) {
@@ -752,6 +772,10 @@ Optimizer::Optimizer(const ActionOptions&ao):
 
 
 Optimizer::~Optimizer() {
+  // complete the pending communication, its result is not used
+  if(async_comm_pending_ && comm.Get_rank()==0) {
+    async_comm_request_.wait();
+  }
   //
   for(unsigned int i=0; i<ncoeffssets_; i++) {
     if(coeffsOFiles_.size()>0 && getIterationCounter()%coeffs_wstride_!=0) {
@@ -819,6 +843,8 @@ void Optimizer::registerKeywords( Keywords& keys ) {
   keys.reserve("hidden","HESSIAN_FMT","specify format for hessian file(s) (useful for decrease the number of digits in regtests)");
   // Keywords related to the multiple walkers, actived with the useMultipleWalkersKeywords function
   keys.reserveFlag("MULTIPLE_WALKERS",false,"if optimization is to be performed using multiple walkers connected via MPI");
+  keys.reserveFlag("PACKED_COMMUNICATION",false,"if the sampled averages of all the coefficient sets and biases should be summed over MPI processes and walkers using a single buffer. This reduces the number of collective operations at each iteration.");
+  keys.reserveFlag("ASYNC_COMMUNICATION",false,"if the sampled averages should be summed among the multiple walkers with a non-blocking operation that is overlapped with the following MD steps. The coefficients are then updated at the next iteration, that is, with a delay of one iteration. Implies PACKED_COMMUNICATION.");
   // Keywords related to the mask file, actived with the useMaskKeywords function
   keys.reserve("optional","MASK_FILE","read in a mask file which allows one to employ different step sizes for different coefficients and/or deactivate the optimization of certain coefficients (by putting values of 0.0). One can write out the resulting mask by using the OUTPUT_MASK_FILE keyword.");
   keys.reserve("optional","OUTPUT_MASK_FILE","Name of the file to write out the mask resulting from using the MASK_FILE keyword. Can also be used to generate a template mask file.");
@@ -866,6 +892,8 @@ void Optimizer::useHessianKeywords(Keywords& keys) {
 
 void Optimizer::useMultipleWalkersKeywords(Keywords& keys) {
   keys.use("MULTIPLE_WALKERS");
+  keys.use("PACKED_COMMUNICATION");
+  keys.use("ASYNC_COMMUNICATION");
 }
 
 
@@ -985,10 +1013,72 @@ std::vector<CoeffsMatrix*> Optimizer::enableHessian(VesBias* bias_pntr_in, const
 // }
 
 
+void Optimizer::packSampledAverages(std::vector<double>& buffer) {
+  size_t size=0;
+  for(unsigned int i=0; i<nbiases_; i++) {
+    size += bias_pntrs_[i]->getPackedAveragesSize();
+  }
+  buffer.resize(size);
+  size_t offset=0;
+  for(unsigned int i=0; i<nbiases_; i++) {
+    bias_pntrs_[i]->packSampledAverages(buffer.data()+offset,use_mwalkers_mpi_);
+    offset += bias_pntrs_[i]->getPackedAveragesSize();
+  }
+  comm.Sum(buffer);
+}
+
+
+void Optimizer::updateGradientAndHessianFromPacked(const std::vector<double>& buffer) {
+  size_t offset=0;
+  for(unsigned int i=0; i<nbiases_; i++) {
+    bias_pntrs_[i]->updateGradientAndHessianFromPacked(buffer.data()+offset);
+    offset += bias_pntrs_[i]->getPackedAveragesSize();
+  }
+}
+
+
+void Optimizer::updateGradientAndHessianPacked() {
+  packSampledAverages(comm_buffer_);
+  if(use_mwalkers_mpi_) {
+    if(comm.Get_rank()==0) {multi_sim_comm.Sum(comm_buffer_);}
+    comm.Bcast(comm_buffer_,0);
+  }
+  updateGradientAndHessianFromPacked(comm_buffer_);
+}
+
+
+bool Optimizer::updateGradientAndHessianAsync() {
+  std::vector<double> buffer;
+  packSampledAverages(buffer);
+  // complete the communication started at the previous iteration
+  bool updated=false;
+  if(async_comm_pending_) {
+    if(comm.Get_rank()==0) {async_comm_request_.wait();}
+    comm.Bcast(comm_buffer_,0);
+    updateGradientAndHessianFromPacked(comm_buffer_);
+    updated=true;
+  }
+  // and start the one for the current iteration
+  comm_buffer_.swap(buffer);
+  if(comm.Get_rank()==0) {async_comm_request_=multi_sim_comm.Isum(comm_buffer_);}
+  async_comm_pending_=true;
+  return updated;
+}
+
+
 void Optimizer::update() {
   if(onStep() && !isFirstStep) {
-    for(unsigned int i=0; i<nbiases_; i++) {
-      bias_pntrs_[i]->updateGradientAndHessian(use_mwalkers_mpi_);
+    if(async_comm_) {
+      // nothing to update at the first iteration
+      if(!updateGradientAndHessianAsync()) {return;}
+    }
+    else if(packed_comm_) {
+      updateGradientAndHessianPacked();
+    }
+    else {
+      for(unsigned int i=0; i<nbiases_; i++) {
+        bias_pntrs_[i]->updateGradientAndHessian(use_mwalkers_mpi_);
+      }
     }
     for(unsigned int i=0; i<ncoeffssets_; i++) {
       if(gradient_pntrs_[i]->isActive()) {coeffsUpdate(i);}
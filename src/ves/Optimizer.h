@@ -26,6 +26,7 @@
 
 #include "core/ActionPilot.h"
 #include "core/ActionWithValue.h"
+#include "tools/Communicator.h"
 
 #include <vector>
 #include <string>
@@ -72,6 +73,13 @@ private:
   //
   bool use_mwalkers_mpi_;
   bool mwalkers_mpi_single_files_;
+  // sum the sampled averages of all biases with a single collective
+  bool packed_comm_;
+  // sum them among the walkers while the simulation goes on, and use them at the next iteration
+  bool async_comm_;
+  bool async_comm_pending_;
+  std::vector<double> comm_buffer_;
+  Communicator::Request async_comm_request_;
   //
   std::vector<bool> dynamic_targetdists_;
   unsigned int ustride_targetdist_;
@@ -128,6 +136,10 @@ private:
   void writeOutputFiles(const unsigned int coeffs_id = 0);
   void readCoeffsFromFiles(const std::vector<std::string>&, const bool);
   void setAllCoeffsSetIterationCounters();
+  void packSampledAverages(std::vector<double>&);
+  void updateGradientAndHessianFromPacked(const std::vector<double>&);
+  void updateGradientAndHessianPacked();
+  bool updateGradientAndHessianAsync();
 protected:
   void turnOnHessian();
   void turnOffHessian();
@@ -422,36 +422,76 @@ void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
       if(aver_counters[k]==0) {walker_weight=0.0;}
       multiSimSumAverages(k,walker_weight);
     }
-    // NOTE: this assumes that all walkers have the same TargetDist, might change later on!!
-    Gradient(k).setValues( TargetDistAverages(k) - sampled_averages[k] );
-    Hessian(k) = computeCovarianceFromAverages(k);
-    Hessian(k) *= getBeta();
-
-    if(optimization_threshold_ != 0.0) {
-      for(size_t c_id=0; c_id < sampled_averages[k].size(); ++c_id) {
-        if(fabs(sampled_averages[k][c_id]) < optimization_threshold_) {
-          Gradient(k).setValue(c_id, 0.0);
-          Hessian(k).setValue(c_id, c_id, 0.0);
-        }
-      }
-    }
     //
-    Gradient(k).activate();
-    Hessian(k).activate();
-    //
-    // Check the total number of samples (from all walkers) and deactivate the Gradient and Hessian if it
-    // is zero
+    // Check the total number of samples (from all walkers), the Gradient and Hessian
+    // are deactivated if it is zero
     unsigned int total_samples = aver_counters[k];
     if(use_mwalkers_mpi) {
       if(comm.Get_rank()==0) {multi_sim_comm.Sum(total_samples);}
       comm.Bcast(total_samples,0);
     }
-    if(total_samples==0) {
-      Gradient(k).deactivate();
-      Gradient(k).clear();
-      Hessian(k).deactivate();
-      Hessian(k).clear();
+    setGradientAndHessian(k,sampled_averages[k],sampled_cross_averages[k],total_samples);
+    //
+    std::fill(sampled_averages[k].begin(), sampled_averages[k].end(), 0.0);
+    std::fill(sampled_cross_averages[k].begin(), sampled_cross_averages[k].end(), 0.0);
+    aver_counters[k]=0;
+  }
+}
+
+
+void VesBias::setGradientAndHessian(const unsigned int k, const std::vector<double>& averages, const std::vector<double>& cross_averages, const unsigned int total_samples) {
+  // NOTE: this assumes that all walkers have the same TargetDist, might change later on!!
+  Gradient(k).setValues( TargetDistAverages(k) - averages );
+  Hessian(k) = computeCovarianceFromAverages(k,averages,cross_averages);
+  Hessian(k) *= getBeta();
+
+  if(optimization_threshold_ != 0.0) {
+    for(size_t c_id=0; c_id < averages.size(); ++c_id) {
+      if(fabs(averages[c_id]) < optimization_threshold_) {
+        Gradient(k).setValue(c_id, 0.0);
+        Hessian(k).setValue(c_id, c_id, 0.0);
+      }
     }
+  }
+  //
+  Gradient(k).activate();
+  Hessian(k).activate();
+  //
+  if(total_samples==0) {
+    Gradient(k).deactivate();
+    Gradient(k).clear();
+    Hessian(k).deactivate();
+    Hessian(k).clear();
+  }
+}
+
+
+size_t VesBias::getPackedAveragesSize() const {
+  // for each coefficient set: the averages, the cross averages, the weight of the walker and the number of samples
+  size_t size=0;
+  for(unsigned int k=0; k<ncoeffssets_; k++) {
+    size += sampled_averages[k].size() + sampled_cross_averages[k].size() + 2;
+  }
+  return size;
+}
+
+
+void VesBias::packSampledAverages(double* buffer, const bool use_mwalkers_mpi) {
+  // the averages are weighted as in multiSimSumAverages(), so that the buffers of all ranks
+  // and walkers can be simply summed. The weight and the number of samples are only
+  // given by the first rank of each walker, as they are the same for all the ranks.
+  size_t n=0;
+  for(unsigned int k=0; k<ncoeffssets_; k++) {
+    double walker_weight=1.0;
+    if(use_mwalkers_mpi && aver_counters[k]==0) {walker_weight=0.0;}
+    for(size_t i=0; i<sampled_averages[k].size(); i++) {
+      buffer[n++] = walker_weight*sampled_averages[k][i];
+    }
+    for(size_t i=0; i<sampled_cross_averages[k].size(); i++) {
+      buffer[n++] = walker_weight*sampled_cross_averages[k][i];
+    }
+    buffer[n++] = comm.Get_rank()==0 ? walker_weight : 0.0;
+    buffer[n++] = comm.Get_rank()==0 ? static_cast<double>(aver_counters[k]) : 0.0;
     //
     std::fill(sampled_averages[k].begin(), sampled_averages[k].end(), 0.0);
     std::fill(sampled_cross_averages[k].begin(), sampled_cross_averages[k].end(), 0.0);
@@ -460,6 +500,24 @@ void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
 }
 
 
+void VesBias::updateGradientAndHessianFromPacked(const double* buffer) {
+  size_t n=0;
+  for(unsigned int k=0; k<ncoeffssets_; k++) {
+    size_t naver = sampled_averages[k].size();
+    size_t ncross = sampled_cross_averages[k].size();
+    double norm_weights = buffer[n+naver+ncross];
+    if(norm_weights>0.0) {norm_weights=1.0/norm_weights;}
+    std::vector<double> averages(naver);
+    std::vector<double> cross_averages(ncross);
+    for(size_t i=0; i<naver; i++) {averages[i] = norm_weights*buffer[n++];}
+    for(size_t i=0; i<ncross; i++) {cross_averages[i] = norm_weights*buffer[n++];}
+    n++;
+    unsigned int total_samples = static_cast<unsigned int>(buffer[n++]+0.5);
+    setGradientAndHessian(k,averages,cross_averages,total_samples);
+  }
+}
+
+
 void VesBias::multiSimSumAverages(const unsigned int c_id, const double walker_weight) {
   plumed_massert(walker_weight>=0.0,"the weight of the walker cannot be negative!");
   if(walker_weight!=1.0) {
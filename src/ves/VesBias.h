@@ -123,8 +123,9 @@ private:
   double optimization_threshold_;
 private:
   void initializeCoeffs(std::unique_ptr<CoeffsVector>);
-  std::vector<double> computeCovarianceFromAverages(const unsigned int) const;
+  std::vector<double> computeCovarianceFromAverages(const unsigned int, const std::vector<double>&, const std::vector<double>&) const;
   void multiSimSumAverages(const unsigned int, const double walker_weight=1.0);
+  void setGradientAndHessian(const unsigned int, const std::vector<double>&, const std::vector<double>&, const unsigned int);
 protected:
   //
   void checkThatTemperatureIsGiven();
@@ -199,6 +200,10 @@ public:
   unsigned int getIterationCounter() const;
   //
   void updateGradientAndHessian(const bool);
+  // to sum the sampled averages of all coefficient sets with a single collective
+  size_t getPackedAveragesSize() const;
+  void packSampledAverages(double*, const bool);
+  void updateGradientAndHessianFromPacked(const double*);
   void clearGradientAndHessian() {};
   //
   virtual void updateTargetDistributions() {};
@@ -360,19 +365,19 @@ void VesBias::applyBiasCutoff(double& bias, std::vector<double>& forces, std::ve
 
 
 inline
-std::vector<double> VesBias::computeCovarianceFromAverages(const unsigned int c_id) const {
+std::vector<double> VesBias::computeCovarianceFromAverages(const unsigned int c_id, const std::vector<double>& averages, const std::vector<double>& cross_averages) const {
   size_t ncoeffs = numberOfCoeffs(c_id);
-  std::vector<double> covariance(sampled_cross_averages[c_id].size(),0.0);
+  std::vector<double> covariance(cross_averages.size(),0.0);
   // diagonal part
   for(size_t i=0; i<ncoeffs; i++) {
     size_t midx = getHessianIndex(i,i,c_id);
-    covariance[midx] = sampled_cross_averages[c_id][midx] - sampled_averages[c_id][i]*sampled_averages[c_id][i];
+    covariance[midx] = cross_averages[midx] - averages[i]*averages[i];
   }
   if(!diagonal_hessian_) {
     for(size_t i=0; i<ncoeffs; i++) {
       for(size_t j=(i+1); j<ncoeffs; j++) {
         size_t midx = getHessianIndex(i,j,c_id);
-        covariance[midx] = sampled_cross_averages[c_id][midx] - sampled_averages[c_id][i]*sampled_averages[c_id][j];
+        covariance[midx] = cross_averages[midx] - averages[i]*averages[j];
       }
     }
   }
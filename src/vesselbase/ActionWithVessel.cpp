@@ -30,10 +30,50 @@
 #include "StoreDataVessel.h"
 #include "tools/OpenMP.h"
 #include "tools/Stopwatch.h"
+#include <algorithm>
 
 namespace PLMD {
 namespace vesselbase {
 
+/// Size of the blocks in which buffers are split when they are reduced
+static const unsigned reductionBlock=64;
+
+/// Sum a vector over all the processes, only communicating the blocks
+/// that are non-zero on at least one process.
+/// Buffers of multicolvars contain the derivatives of many quantities, most of which are zero
+/// on each process, so that this is much cheaper than summing the full vector.
+template<typename T>
+static void sumNonZeroBlocks( Communicator& comm, std::vector<T>& v ) {
+  if( comm.Get_size()==1 ) return;
+  const unsigned n=v.size();
+  const unsigned nblocks=(n+reductionBlock-1)/reductionBlock;
+  std::vector<unsigned> active( nblocks, 0 );
+  for(unsigned b=0; b<nblocks; ++b) {
+    const unsigned end=std::min( n, (b+1)*reductionBlock );
+    for(unsigned i=b*reductionBlock; i<end; ++i) if( v[i]!=T(0) ) { active[b]=1; break; }
+  }
+  comm.Sum( active );
+  // The list of active blocks is the same on all processes
+  unsigned nactive=0;
+  for(unsigned b=0; b<nblocks; ++b) if( active[b]>0 ) nactive++;
+  if( 2*nactive>nblocks ) { comm.Sum( v ); return; }
+  if( nactive==0 ) return;
+  std::vector<T> packed( nactive*reductionBlock, T(0) );
+  unsigned k=0;
+  for(unsigned b=0; b<nblocks; ++b) {
+    if( active[b]==0 ) continue;
+    const unsigned end=std::min( n, (b+1)*reductionBlock );
+    std::copy( v.begin()+b*reductionBlock, v.begin()+end, packed.begin()+k ); k+=reductionBlock;
+  }
+  comm.Sum( packed );
+  k=0;
+  for(unsigned b=0; b<nblocks; ++b) {
+    if( active[b]==0 ) continue;
+    const unsigned end=std::min( n, (b+1)*reductionBlock );
+    std::copy( packed.begin()+k, packed.begin()+k+(end-b*reductionBlock), v.begin()+b*reductionBlock ); k+=reductionBlock;
+  }
+}
+
 void ActionWithVessel::registerKeywords(Keywords& keys) {
   keys.add("hidden","TOL","this keyword can be used to speed up your calculation. When accumulating sums in which the individual "
            "terms are numbers in between zero and one it is assumed that terms less than a certain tolerance "
@@ -281,11 +321,15 @@ void ActionWithVessel::runAllTasks() {
   // Switch off calculation of derivatives in main loop
   if( dertime_can_be_off ) dertime=false;
 
+  // Buffers of the threads that have been used, reduced at the end of the loop
+  std::vector<const double*> omp_buffers( nt, NULL );
+
   if(timers) stopwatch.start("2 Loop over tasks");
   #pragma omp parallel num_threads(nt)
   {
     std::vector<double> omp_buffer;
     if( nt>1 ) omp_buffer.resize( bufsize, 0.0 );
+    bool used=false;
     MultiValue myvals( getNumberOfQuantities(), getNumberOfDerivatives() );
     MultiValue bvals( getNumberOfQuantities(), getNumberOfDerivatives() );
     myvals.clearAll(); bvals.clearAll();
@@ -307,6 +351,7 @@ void ActionWithVessel::runAllTasks() {
       // Now calculate all the functions
       // If the contribution of this quantity is very small at neighbour list time ignore it
       // until next neighbour list time
+      used=true;
       if( nt>1 ) {
         calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
       } else {
@@ -316,8 +361,21 @@ void ActionWithVessel::runAllTasks() {
       // Clear the value
       myvals.clearAll();
     }
-    #pragma omp critical
-    if(nt>1) for(unsigned i=0; i<bufsize; ++i) buffer[i]+=omp_buffer[i];
+    // The buffers are summed in parallel, with each thread taking care of
+    // a set of blocks and skipping the buffers of threads that did not contribute
+    if( nt>1 ) {
+      if( used ) omp_buffers[OpenMP::getThreadNum()]=omp_buffer.data();
+      #pragma omp barrier
+      const unsigned nblocks=(bufsize+reductionBlock-1)/reductionBlock;
+      #pragma omp for schedule(static)
+      for(unsigned b=0; b<nblocks; ++b) {
+        const unsigned end=std::min( bufsize, (b+1)*reductionBlock );
+        for(unsigned t=0; t<nt; ++t) {
+          if( !omp_buffers[t] ) continue;
+          for(unsigned i=b*reductionBlock; i<end; ++i) buffer[i]+=omp_buffers[t][i];
+        }
+      }
+    }
   }
   if(timers) stopwatch.stop("2 Loop over tasks");
   // Turn back on derivative calculation
@@ -325,10 +383,11 @@ void ActionWithVessel::runAllTasks() {
 
   if(timers) stopwatch.start("3 MPI gather");
   // MPI Gather everything
-  if( !serial && buffer.size()>0 ) comm.Sum( buffer );
+  if( !serial && buffer.size()>0 ) sumNonZeroBlocks( comm, buffer );
   // MPI Gather index stores
   if( mydata && !lowmem && !noderiv ) {
-    comm.Sum( der_list ); mydata->setActiveValsAndDerivatives( der_list );
+    sumNonZeroBlocks( comm, der_list );
+    mydata->setActiveValsAndDerivatives( der_list );
   }
   // Update the elements that are makign contributions to the sum here
   // this causes problems if we do it in prepare